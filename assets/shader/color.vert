@@ -12,7 +12,27 @@ out VertexData {
 } vert;
 
 uniform mat4 modelMatrix;
-uniform mat4 viewProjMatrix;
+
+// per-frame camera and light data, written once per frame by FrameUniforms (identical in all scene shaders)
+#define MAX_DIR_LIGHTS 4
+#define MAX_POINT_LIGHTS 8
+struct DirectionalLight {
+	vec3 color;
+	vec3 direction;
+};
+struct PointLight {
+	vec3 color;
+	vec3 position;
+	vec3 attenuation;
+};
+layout(std140, binding = 0) uniform FrameData {
+	mat4 viewProjMatrix;
+	vec3 camera_world;
+	int dirLightCount;
+	int pointLightCount;
+	DirectionalLight dirLights[MAX_DIR_LIGHTS];
+	PointLight pointLights[MAX_POINT_LIGHTS];
+};
 
 void main() {
 	gl_Position = viewProjMatrix * modelMatrix * vec4(position, 1);
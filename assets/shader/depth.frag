@@ -0,0 +1,5 @@
+#version 430 core
+
+// depth pre-pass: no color output, color writes are masked and the driver only writes depth
+void main() {
+}
@@ -0,0 +1,47 @@
+#version 430 core
+
+// depth pre-pass: only the position is read, the shading pass tests against this depth with GL_EQUAL
+// gl_Position is computed with the same expressions as in texture.vert and Phong.vertex and is invariant in all three,
+// so both passes produce bit identical depths
+layout(location = 0) in vec3 position;
+
+invariant gl_Position;
+
+uniform mat4 modelMatrix;
+
+// per-frame camera and light data, written once per frame by FrameUniforms (identical in all scene shaders)
+#define MAX_DIR_LIGHTS 4
+#define MAX_POINT_LIGHTS 8
+struct DirectionalLight {
+	vec3 color;
+	vec3 direction;
+};
+struct PointLight {
+	vec3 color;
+	vec3 position;
+	vec3 attenuation;
+};
+layout(std140, binding = 0) uniform FrameData {
+	mat4 viewProjMatrix;
+	vec3 camera_world;
+	int dirLightCount;
+	int pointLightCount;
+	DirectionalLight dirLights[MAX_DIR_LIGHTS];
+	PointLight pointLights[MAX_POINT_LIGHTS];
+};
+
+// instanced draws: the model matrix comes from the per-instance buffer instead of the uniform
+uniform bool instanced;
+layout(location = 3) in mat4 instanceModelMatrix;
+
+// quantized vertices: positions relative to the mesh bounds
+uniform bool quantized;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+void main() {
+	vec3 objectPosition = quantized ? positionOffset + positionScale * position : position;
+	mat4 model = instanced ? instanceModelMatrix : modelMatrix;
+	vec4 position_world_ = model * vec4(objectPosition, 1);
+	gl_Position = viewProjMatrix * position_world_;
+}
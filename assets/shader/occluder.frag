@@ -0,0 +1,8 @@
+#version 430 core
+
+// level 0 of the pyramid stores the window depth, the clear value 1 is the far plane
+layout(location = 0) out float depth;
+
+void main() {
+	depth = gl_FragCoord.z;
+}
@@ -0,0 +1,37 @@
+#version 430 core
+
+// depth of the large occluders for the hierarchical-Z pyramid, see HiZCuller
+layout(location = 0) in vec3 position;
+
+uniform mat4 modelMatrix;
+
+// per-frame camera and light data, written once per frame by FrameUniforms (identical in all scene shaders)
+#define MAX_DIR_LIGHTS 4
+#define MAX_POINT_LIGHTS 8
+struct DirectionalLight {
+	vec3 color;
+	vec3 direction;
+};
+struct PointLight {
+	vec3 color;
+	vec3 position;
+	vec3 attenuation;
+};
+layout(std140, binding = 0) uniform FrameData {
+	mat4 viewProjMatrix;
+	vec3 camera_world;
+	int dirLightCount;
+	int pointLightCount;
+	DirectionalLight dirLights[MAX_DIR_LIGHTS];
+	PointLight pointLights[MAX_POINT_LIGHTS];
+};
+
+// quantized vertices: positions relative to the mesh bounds
+uniform bool quantized;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+void main() {
+	vec3 objectPosition = quantized ? positionOffset + positionScale * position : position;
+	gl_Position = viewProjMatrix * modelMatrix * vec4(objectPosition, 1);
+}
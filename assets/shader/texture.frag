@@ -13,22 +13,32 @@ in VertexData {
 
 out vec4 color;
 
-uniform vec3 camera_world;
-
 uniform vec3 materialCoefficients; // x = ambient, y = diffuse, z = specular 
 uniform float specularAlpha;
 uniform sampler2D diffuseTexture;
+uniform sampler2DArray diffuseTextureArray;
+uniform int diffuseLayer; // layer of diffuseTextureArray, -1 samples diffuseTexture
 
-uniform struct DirectionalLight {
+// per-frame camera and light data, written once per frame by FrameUniforms (identical in all scene shaders)
+#define MAX_DIR_LIGHTS 4
+#define MAX_POINT_LIGHTS 8
+struct DirectionalLight {
 	vec3 color;
 	vec3 direction;
-} dirL;
-
-uniform struct PointLight {
+};
+struct PointLight {
 	vec3 color;
 	vec3 position;
 	vec3 attenuation;
-} pointL;
+};
+layout(std140, binding = 0) uniform FrameData {
+	mat4 viewProjMatrix;
+	vec3 camera_world;
+	int dirLightCount;
+	int pointLightCount;
+	DirectionalLight dirLights[MAX_DIR_LIGHTS];
+	PointLight pointLights[MAX_POINT_LIGHTS];
+};
 
 
 vec3 phong(vec3 n, vec3 l, vec3 v, vec3 diffuseC, float diffuseF, vec3 specularC, float specularF, float alpha, bool attenuate, vec3 attenuation) {
@@ -44,13 +54,17 @@ void main() {
 	vec3 n = normalize(vert.normal_world);
 	vec3 v = normalize(camera_world - vert.position_world);
 	
-	vec3 texColor = texture(diffuseTexture, vert.uv).rgb;
+	vec3 texColor = diffuseLayer < 0 ? texture(diffuseTexture, vert.uv).rgb : texture(diffuseTextureArray, vec3(vert.uv, diffuseLayer)).rgb;
 	color = vec4(texColor * materialCoefficients.x, 1); // ambient
 	
-	// add directional light contribution
-	color.rgb += phong(n, -dirL.direction, v, dirL.color * texColor, materialCoefficients.y, dirL.color, materialCoefficients.z, specularAlpha, false, vec3(0));
+	// add directional light contributions
+	for (int i = 0; i < dirLightCount; i++) {
+		color.rgb += phong(n, -dirLights[i].direction, v, dirLights[i].color * texColor, materialCoefficients.y, dirLights[i].color, materialCoefficients.z, specularAlpha, false, vec3(0));
+	}
 			
-	// add point light contribution
-	color.rgb += phong(n, pointL.position - vert.position_world, v, pointL.color * texColor, materialCoefficients.y, pointL.color, materialCoefficients.z, specularAlpha, true, pointL.attenuation);
+	// add point light contributions
+	for (int i = 0; i < pointLightCount; i++) {
+		color.rgb += phong(n, pointLights[i].position - vert.position_world, v, pointLights[i].color * texColor, materialCoefficients.y, pointLights[i].color, materialCoefficients.z, specularAlpha, true, pointLights[i].attenuation);
+	}
 }
 
@@ -15,14 +15,58 @@ out VertexData {
 	vec2 uv;
 } vert;
 
+// the depth pre-pass (depth.vert) computes the same position, the shading pass tests against it with GL_EQUAL
+invariant gl_Position;
+
 uniform mat4 modelMatrix;
-uniform mat4 viewProjMatrix;
 uniform mat3 normalMatrix;
 
+// per-frame camera and light data, written once per frame by FrameUniforms (identical in all scene shaders)
+#define MAX_DIR_LIGHTS 4
+#define MAX_POINT_LIGHTS 8
+struct DirectionalLight {
+	vec3 color;
+	vec3 direction;
+};
+struct PointLight {
+	vec3 color;
+	vec3 position;
+	vec3 attenuation;
+};
+layout(std140, binding = 0) uniform FrameData {
+	mat4 viewProjMatrix;
+	vec3 camera_world;
+	int dirLightCount;
+	int pointLightCount;
+	DirectionalLight dirLights[MAX_DIR_LIGHTS];
+	PointLight pointLights[MAX_POINT_LIGHTS];
+};
+
+// instanced draws: the matrices come from the per-instance buffer instead of the uniforms
+uniform bool instanced;
+layout(location = 3) in mat4 instanceModelMatrix;
+layout(location = 7) in mat3 instanceNormalMatrix;
+
+// quantized vertices: positions relative to the mesh bounds, octahedral encoded normals
+uniform bool quantized;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 octahedralDecode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0 ? 1.0 : -1.0, n.y >= 0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
 void main() {
-	vert.normal_world = normalMatrix * normal;
+	vec3 objectPosition = quantized ? positionOffset + positionScale * position : position;
+	vec3 objectNormal = quantized ? octahedralDecode(normal.xy) : normal;
+	mat4 model = instanced ? instanceModelMatrix : modelMatrix;
+	mat3 normalModel = instanced ? instanceNormalMatrix : normalMatrix;
+
+	vert.normal_world = normalModel * objectNormal;
 	vert.uv = uv;
-	vec4 position_world_ = modelMatrix * vec4(position, 1);
+	vec4 position_world_ = model * vec4(objectPosition, 1);
 	vert.position_world = position_world_.xyz;
 	gl_Position = viewProjMatrix * position_world_;
 }
\ No newline at end of file
@@ -0,0 +1,390 @@
+#include "AssetLoader.h"
+#include <algorithm>
+#include <cstring>
+#include "DDSFile.h"
+#include "GLState.h"
+#include "MeshCache.h"
+
+/* --------------------------------------------- */
+// Helpers
+/* --------------------------------------------- */
+
+/*!
+ * Reads every page of mapped memory, so that the file is read by the worker and not by the render thread during the upload
+ */
+static void touchPages(const void* data, size_t size)
+{
+	const volatile char* bytes = static_cast<const volatile char*>(data);
+	char sum = 0;
+	for (size_t i = 0; i < size; i += 4096) sum += bytes[i];
+	if (size > 0) sum += bytes[size - 1];
+	(void)sum;
+}
+
+/* --------------------------------------------- */
+// Uploads
+/* --------------------------------------------- */
+
+/*!
+ * Uploads all levels of a DDS texture or of the layers of an array texture, in parts of whole block rows
+ */
+class TextureUpload : public AssetLoader::Upload
+{
+protected:
+	/*!
+	 * The DDS file, or one file per layer of an array texture
+	 */
+	std::vector<std::unique_ptr<DDSFile>> _files;
+	std::shared_ptr<Texture> _texture;
+	GLenum _target;
+	unsigned int _mipLevels;
+	GLuint _handle;
+	/*!
+	 * The face of a cubemap or the layer of an array texture
+	 */
+	unsigned int _slice;
+	unsigned int _level, _row;
+	bool _done;
+
+	/*!
+	 * @return the number of faces or layers
+	 */
+	unsigned int getSlices() const { return _target == GL_TEXTURE_2D_ARRAY ? unsigned(_files.size()) : _files[0]->getFaces(); }
+
+public:
+	/*!
+	 * @param files: the DDS file, or one file per layer of an array texture (same format, size and mip levels)
+	 * @param texture: the placeholder to resolve
+	 * @param array: if the files are the layers of an array texture
+	 */
+	TextureUpload(std::vector<std::unique_ptr<DDSFile>> files, std::shared_ptr<Texture> texture, bool array)
+		: _files(std::move(files)), _texture(texture), _target(GL_TEXTURE_2D), _mipLevels(0), _handle(0), _slice(0), _level(0), _row(0), _done(false)
+	{
+		for (const std::unique_ptr<DDSFile>& file : _files) {
+			if (!file->isValid() || file->getFormat() != _files[0]->getFormat() || file->getWidth() != _files[0]->getWidth() || file->getHeight() != _files[0]->getHeight()
+				|| file->getMipLevels() != _files[0]->getMipLevels()) {
+				_done = true;
+				return;
+			}
+		}
+		_mipLevels = _files[0]->getMipLevels();
+		if (array) _target = GL_TEXTURE_2D_ARRAY;
+		else if (_files[0]->isCubemap()) _target = GL_TEXTURE_CUBE_MAP;
+	}
+
+	virtual ~TextureUpload()
+	{
+		// the texture only takes ownership of a complete upload
+		if (!_done) GLState::deleteTextures(1, &_handle);
+	}
+
+	virtual size_t upload(AssetLoader& loader, size_t budget)
+	{
+		// invalid or mismatching files keep the placeholder
+		if (_done) return 0;
+
+		const DDSFile& first = *_files[0];
+		if (_handle == 0) {
+			glGenTextures(1, &_handle);
+			GLState::bindTexture(_target, _handle);
+			if (_target == GL_TEXTURE_2D_ARRAY) glTexStorage3D(_target, _mipLevels, first.getFormat(), first.getWidth(), first.getHeight(), GLsizei(_files.size()));
+			else glTexStorage2D(_target, _mipLevels, first.getFormat(), first.getWidth(), first.getHeight());
+		}
+		GLState::bindTexture(_target, _handle);
+
+		size_t uploaded = 0;
+		while (!_done) {
+			const DDSFile& file = _target == GL_TEXTURE_2D_ARRAY ? *_files[_slice] : first;
+			unsigned int face = _target == GL_TEXTURE_2D_ARRAY ? 0 : _slice;
+			const DDSLevel& level = file.getLevel(face, _level);
+			unsigned int blockRows = (level.height + 3) / 4;
+			size_t rowSize = level.size / blockRows;
+			unsigned int rows = unsigned(std::min<size_t>(blockRows - _row, (budget - std::min(uploaded, budget)) / rowSize));
+			if (rows == 0) {
+				if (uploaded > 0) break;
+				rows = 1;
+			}
+
+			const char* data = static_cast<const char*>(file.getLevelData(face, _level)) + _row * rowSize;
+			size_t size = rows * rowSize;
+			GLintptr offset = loader.stage(data, size);
+			GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, offset >= 0 ? loader.getStagingBuffer() : 0);
+			const void* pixels = offset >= 0 ? (const void*)offset : data;
+
+			unsigned int y = _row * 4;
+			unsigned int height = std::min(rows * 4, level.height - y);
+			if (_target == GL_TEXTURE_2D_ARRAY) {
+				glCompressedTexSubImage3D(_target, _level, 0, y, _slice, level.width, height, 1, file.getFormat(), GLsizei(size), pixels);
+			}
+			else {
+				GLenum faceTarget = _target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+				glCompressedTexSubImage2D(faceTarget, _level, 0, y, level.width, height, file.getFormat(), GLsizei(size), pixels);
+			}
+			uploaded += size;
+
+			// next block rows, level or slice
+			_row += rows;
+			if (_row == blockRows) {
+				_row = 0;
+				if (++_level == _mipLevels) {
+					_level = 0;
+					if (++_slice == getSlices()) _done = true;
+				}
+			}
+		}
+		GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (_done) _texture->resolve(_handle, _target, _mipLevels);
+		else GLState::bindTexture(_target, 0);
+		return uploaded;
+	}
+
+	virtual bool isDone() const { return _done; }
+};
+
+/*!
+ * Uploads the vertex and index buffers of a mesh
+ */
+class MeshUpload : public AssetLoader::Upload
+{
+protected:
+	std::unique_ptr<MeshCacheFile> _file;
+	MeshData _data;
+	std::shared_ptr<Mesh> _mesh;
+	size_t _offset;
+	bool _allocated;
+
+public:
+	MeshUpload(std::unique_ptr<MeshCacheFile> file, const MeshData& data, std::shared_ptr<Mesh> mesh)
+		: _file(std::move(file)), _data(data), _mesh(mesh), _offset(0), _allocated(false)
+	{
+	}
+
+	virtual size_t upload(AssetLoader& loader, size_t budget)
+	{
+		if (!_allocated) {
+			_mesh->allocate(_data, false);
+			_allocated = true;
+		}
+
+		// vertices first, then indices, as if they were one buffer
+		size_t vertexSize = _data.vertexDataSize();
+		size_t totalSize = vertexSize + _data.indexDataSize();
+		size_t uploaded = 0;
+		while (_offset < totalSize && uploaded < budget) {
+			bool vertices = _offset < vertexSize;
+			size_t bufferOffset = vertices ? _offset : _offset - vertexSize;
+			size_t size = std::min((vertices ? vertexSize : totalSize) - _offset, budget - uploaded);
+			const char* data = (vertices ? _data.vertexData() : _data.indexData()) + bufferOffset;
+
+			GLState::bindBuffer(GL_COPY_WRITE_BUFFER, vertices ? _mesh->getVertexBuffer() : _mesh->getIndexBuffer());
+			GLintptr offset = loader.stage(data, size);
+			if (offset >= 0) {
+				GLState::bindBuffer(GL_COPY_READ_BUFFER, loader.getStagingBuffer());
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, bufferOffset, size);
+			}
+			else {
+				glBufferSubData(GL_COPY_WRITE_BUFFER, bufferOffset, size, data);
+			}
+			_offset += size;
+			uploaded += size;
+		}
+		GLState::bindBuffer(GL_COPY_READ_BUFFER, 0);
+		GLState::bindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		if (_offset == totalSize) _mesh->setReady();
+		return uploaded;
+	}
+
+	virtual bool isDone() const { return _allocated && _offset == _data.vertexDataSize() + _data.indexDataSize(); }
+};
+
+/* --------------------------------------------- */
+// Asset loader
+/* --------------------------------------------- */
+
+AssetLoader::AssetLoader(unsigned int workers, size_t uploadBudget)
+	: _stop(false), _activeJobs(0), _uploadBudget(std::max<size_t>(uploadBudget, 1)),
+	_stagingBuffer(0), _stagingMemory(nullptr), _stagingRegion(0), _stagingOffset(0), _latencySum(0.0)
+{
+	memset(&_stats, 0, sizeof(_stats));
+	for (unsigned int i = 0; i < STAGING_REGIONS; i++) _stagingFences[i] = 0;
+
+	// persistent mapping needs ARB_buffer_storage (core in 4.4), otherwise data is uploaded from client memory
+	if (GLEW_ARB_buffer_storage) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &_stagingBuffer);
+		GLState::bindBuffer(GL_COPY_READ_BUFFER, _stagingBuffer);
+		glBufferStorage(GL_COPY_READ_BUFFER, _uploadBudget * STAGING_REGIONS, nullptr, flags);
+		_stagingMemory = static_cast<char*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, _uploadBudget * STAGING_REGIONS, flags));
+		GLState::bindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+
+	for (unsigned int i = 0; i < std::max(workers, 1u); i++) {
+		_workers.push_back(std::thread(&AssetLoader::workerLoop, this));
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_condition.notify_all();
+	for (std::thread& worker : _workers) worker.join();
+
+	for (unsigned int i = 0; i < STAGING_REGIONS; i++) {
+		if (_stagingFences[i] != 0) glDeleteSync(_stagingFences[i]);
+	}
+	if (_stagingBuffer != 0) {
+		GLState::bindBuffer(GL_COPY_READ_BUFFER, _stagingBuffer);
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+		GLState::bindBuffer(GL_COPY_READ_BUFFER, 0);
+		GLState::deleteBuffers(1, &_stagingBuffer);
+	}
+}
+
+void AssetLoader::workerLoop()
+{
+	while (true) {
+		std::pair<std::chrono::high_resolution_clock::time_point, std::function<std::unique_ptr<Upload>()>> job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+			if (_stop) return;
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+			_activeJobs++;
+		}
+
+		std::unique_ptr<Upload> upload = job.second();
+		upload->requested = job.first;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_decoded.push_back(std::move(upload));
+		_activeJobs--;
+	}
+}
+
+void AssetLoader::enqueue(std::function<std::unique_ptr<Upload>()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(std::make_pair(std::chrono::high_resolution_clock::now(), job));
+	}
+	_condition.notify_one();
+}
+
+std::shared_ptr<Texture> AssetLoader::loadTexture(const std::string& file)
+{
+	return loadTextures(std::vector<std::string>(1, file), false);
+}
+
+std::shared_ptr<Texture> AssetLoader::loadTextureArray(const std::vector<std::string>& layerFiles)
+{
+	return loadTextures(layerFiles, true);
+}
+
+std::shared_ptr<Texture> AssetLoader::loadTextures(const std::vector<std::string>& files, bool array)
+{
+	std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+	enqueue([files, array, texture]() {
+		std::vector<std::unique_ptr<DDSFile>> dds;
+		for (const std::string& file : files) {
+			dds.push_back(std::unique_ptr<DDSFile>(new DDSFile("assets/textures/" + file)));
+			const DDSFile& f = *dds.back();
+			for (unsigned int face = 0; f.isValid() && face < f.getFaces(); face++) {
+				for (unsigned int level = 0; level < f.getMipLevels(); level++) {
+					touchPages(f.getLevelData(face, level), f.getLevel(face, level).size);
+				}
+			}
+		}
+		return std::unique_ptr<Upload>(new TextureUpload(std::move(dds), texture, array));
+	});
+	return texture;
+}
+
+std::shared_ptr<Mesh> AssetLoader::loadMesh(std::function<GeometryData()> create, VertexLayout layout)
+{
+	std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+	enqueue([create, layout, mesh]() {
+		GeometryData data = create();
+		data.layout = layout;
+		return std::unique_ptr<Upload>(new MeshUpload(nullptr, Mesh::prepare(data), mesh));
+	});
+	return mesh;
+}
+
+std::shared_ptr<Mesh> AssetLoader::loadMeshCache(const std::string& path)
+{
+	std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+	enqueue([path, mesh]() {
+		std::unique_ptr<MeshCacheFile> file = MeshCache::load(path.c_str());
+		MeshData data = Mesh::prepare(*file);
+		touchPages(data.vertexData(), data.vertexDataSize());
+		touchPages(data.indexData(), data.indexDataSize());
+		return std::unique_ptr<Upload>(new MeshUpload(std::move(file), data, mesh));
+	});
+	return mesh;
+}
+
+GLintptr AssetLoader::stage(const void* data, size_t size)
+{
+	if (_stagingMemory == nullptr || _stagingOffset + size > _uploadBudget) return -1;
+
+	GLintptr offset = GLintptr(_stagingRegion * _uploadBudget + _stagingOffset);
+	memcpy(_stagingMemory + offset, data, size);
+	_stagingOffset += size;
+	return offset;
+}
+
+void AssetLoader::update()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (std::unique_ptr<Upload>& upload : _decoded) _uploads.push_back(std::move(upload));
+		_decoded.clear();
+	}
+
+	// continue in the next region, which the GPU may still read from three frames ago
+	_stagingRegion = (_stagingRegion + 1) % STAGING_REGIONS;
+	_stagingOffset = 0;
+	if (_stagingFences[_stagingRegion] != 0) {
+		glClientWaitSync(_stagingFences[_stagingRegion], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		glDeleteSync(_stagingFences[_stagingRegion]);
+		_stagingFences[_stagingRegion] = 0;
+	}
+
+	size_t uploaded = 0;
+	while (!_uploads.empty() && uploaded < _uploadBudget) {
+		Upload& upload = *_uploads.front();
+		uploaded += upload.upload(*this, _uploadBudget - uploaded);
+		if (!upload.isDone()) break;
+
+		double latency = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - upload.requested).count();
+		_latencySum += latency;
+		_stats.completed++;
+		_stats.maxLatency = std::max(_stats.maxLatency, latency);
+		_stats.averageLatency = _latencySum / double(_stats.completed);
+		_uploads.pop_front();
+	}
+	_stats.uploadedBytes = uploaded;
+
+	if (_stagingOffset > 0) _stagingFences[_stagingRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool AssetLoader::isIdle()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _jobs.empty() && _activeJobs == 0 && _decoded.empty() && _uploads.empty();
+}
+
+AssetLoaderStats AssetLoader::getStats()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	AssetLoaderStats stats = _stats;
+	stats.pendingLoads = _jobs.size() + _activeJobs;
+	stats.pendingUploads = _decoded.size() + _uploads.size();
+	return stats;
+}
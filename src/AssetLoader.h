@@ -0,0 +1,201 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <GL\glew.h>
+#include "Geometry.h"
+#include "Mesh.h"
+#include "Texture.h"
+
+/*!
+ * Statistics of the asset loader, to tune the number of workers and the upload budget
+ */
+struct AssetLoaderStats {
+	/*!
+	 * Assets waiting for or being read and decoded by a worker
+	 */
+	size_t pendingLoads;
+	/*!
+	 * Assets decoded and waiting for or being uploaded by the render thread
+	 */
+	size_t pendingUploads;
+	/*!
+	 * Bytes uploaded in the last update
+	 */
+	size_t uploadedBytes;
+	/*!
+	 * Number of completely uploaded assets
+	 */
+	size_t completed;
+	/*!
+	 * Average and maximum time from the request to the resolved handle in seconds
+	 */
+	double averageLatency;
+	double maxLatency;
+};
+
+/*!
+ * Loads textures and meshes in the background
+ * A pool of worker threads reads and decodes the files, the render thread uploads the decoded data
+ * in update() with a fixed number of bytes per frame through a persistently mapped staging buffer.
+ * The load functions return placeholder handles immediately, which resolve when their upload is complete.
+ */
+class AssetLoader
+{
+public:
+	/*!
+	 * An asset that is uploaded in parts
+	 */
+	class Upload
+	{
+	public:
+		std::chrono::high_resolution_clock::time_point requested;
+
+		virtual ~Upload() {}
+		/*!
+		 * Uploads the next part of the asset
+		 * @param loader: the loader, provides the staging buffer
+		 * @param budget: maximum number of bytes to upload (at least one part is uploaded)
+		 * @return the number of uploaded bytes
+		 */
+		virtual size_t upload(AssetLoader& loader, size_t budget) = 0;
+		/*!
+		 * @return if the asset is complete and its handle is resolved
+		 */
+		virtual bool isDone() const = 0;
+	};
+
+protected:
+	std::vector<std::thread> _workers;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _stop;
+
+	/*!
+	 * Decode jobs for the workers, each returns the upload of its asset
+	 */
+	std::deque<std::pair<std::chrono::high_resolution_clock::time_point, std::function<std::unique_ptr<Upload>()>>> _jobs;
+	/*!
+	 * Decoded assets handed from the workers to the render thread
+	 */
+	std::vector<std::unique_ptr<Upload>> _decoded;
+	size_t _activeJobs;
+
+	/*!
+	 * Assets being uploaded, only used by the render thread
+	 */
+	std::deque<std::unique_ptr<Upload>> _uploads;
+	size_t _uploadBudget;
+
+	/*!
+	 * Number of regions of the staging buffer, i.e. frames that may be in flight
+	 */
+	static const unsigned int STAGING_REGIONS = 3;
+
+	/*!
+	 * Persistently mapped staging buffer with one region of the upload budget per frame in flight
+	 */
+	GLuint _stagingBuffer;
+	char* _stagingMemory;
+	GLsync _stagingFences[STAGING_REGIONS];
+	unsigned int _stagingRegion;
+	size_t _stagingOffset;
+
+	AssetLoaderStats _stats;
+	double _latencySum;
+
+	/*!
+	 * Takes jobs from the queue until the loader is destroyed
+	 */
+	void workerLoop();
+
+	/*!
+	 * Adds a decode job
+	 */
+	void enqueue(std::function<std::unique_ptr<Upload>()> job);
+
+	/*!
+	 * Loads a DDS texture or the layers of an array texture in the background
+	 */
+	std::shared_ptr<Texture> loadTextures(const std::vector<std::string>& files, bool array);
+
+public:
+	/*!
+	 * Starts the workers and creates the staging buffer
+	 * @param workers: number of worker threads
+	 * @param uploadBudget: maximum number of bytes uploaded per frame
+	 */
+	AssetLoader(unsigned int workers, size_t uploadBudget);
+	/*!
+	 * Stops the workers, unfinished assets stay placeholders
+	 */
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	/*!
+	 * Loads a DDS texture in the background
+	 * @param file: path to the texture file relative to assets/textures
+	 * @return a placeholder texture that resolves when the texture is uploaded
+	 */
+	std::shared_ptr<Texture> loadTexture(const std::string& file);
+
+	/*!
+	 * Loads an array texture with one DDS file per layer in the background
+	 * @param layerFiles: paths to the texture files relative to assets/textures, all with the same format, size and number of mip levels
+	 * @return a placeholder texture that resolves when all layers are uploaded
+	 */
+	std::shared_ptr<Texture> loadTextureArray(const std::vector<std::string>& layerFiles);
+
+	/*!
+	 * Creates a mesh in the background
+	 * @param create: creates the geometry data, called on a worker thread
+	 * @param layout: vertex layout of the mesh
+	 * @return a placeholder mesh that becomes ready when the mesh is uploaded
+	 */
+	std::shared_ptr<Mesh> loadMesh(std::function<GeometryData()> create, VertexLayout layout);
+
+	/*!
+	 * Loads the mesh cache of an OBJ file in the background, (re)building it if necessary
+	 * @param path: path to the OBJ file
+	 * @return a placeholder mesh that becomes ready when the mesh is uploaded
+	 */
+	std::shared_ptr<Mesh> loadMeshCache(const std::string& path);
+
+	/*!
+	 * Uploads decoded assets, at most the upload budget per call
+	 * Has to be called once per frame on the render thread.
+	 */
+	void update();
+
+	/*!
+	 * @return if no asset is waiting to be decoded or uploaded
+	 */
+	bool isIdle();
+
+	/*!
+	 * @return the loader statistics
+	 */
+	AssetLoaderStats getStats();
+
+	/*!
+	 * Copies data into the current region of the staging buffer
+	 * @param data: the data to upload
+	 * @param size: size of the data in bytes
+	 * @return the offset of the data in the staging buffer, -1 if it was not copied
+	 * (no persistent mapping or the region is full), then the data has to be uploaded from client memory
+	 */
+	GLintptr stage(const void* data, size_t size);
+	/*!
+	 * @return the staging buffer, to be bound as GL_PIXEL_UNPACK_BUFFER or GL_COPY_READ_BUFFER
+	 */
+	GLuint getStagingBuffer() const { return _stagingBuffer; }
+};
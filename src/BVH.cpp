@@ -0,0 +1,402 @@
+#include "BVH.h"
+#include <algorithm>
+#include <cfloat>
+
+/* --------------------------------------------- */
+// Helpers
+/* --------------------------------------------- */
+
+/*!
+ * @return half the surface area of a box, the factor does not matter for the heuristic
+ */
+static float halfArea(const glm::vec3& min, const glm::vec3& max)
+{
+	glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+	return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+static bool overlaps(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB)
+{
+	return minA.x <= maxB.x && minA.y <= maxB.y && minA.z <= maxB.z
+		&& minB.x <= maxA.x && minB.y <= maxA.y && minB.z <= maxA.z;
+}
+
+/*!
+ * One bin of the surface area heuristic
+ */
+struct BVHBin {
+	glm::vec3 min, max;
+	uint32_t count;
+};
+
+/* --------------------------------------------- */
+// Building
+/* --------------------------------------------- */
+
+BVH::BVH()
+	: _buildCost(0.0f)
+{
+}
+
+void BVH::clear()
+{
+	_nodes.clear();
+	_objects.clear();
+	_boxMin.clear();
+	_boxMax.clear();
+	_buildCost = 0.0f;
+}
+
+uint32_t BVH::add(const glm::vec3& min, const glm::vec3& max)
+{
+	_boxMin.push_back(min);
+	_boxMax.push_back(max);
+	return uint32_t(_boxMin.size() - 1);
+}
+
+void BVH::update(uint32_t object, const glm::vec3& min, const glm::vec3& max)
+{
+	_boxMin[object] = min;
+	_boxMax[object] = max;
+}
+
+void BVH::build()
+{
+	_nodes.clear();
+	_objects.resize(_boxMin.size());
+	for (uint32_t i = 0; i < _objects.size(); i++) _objects[i] = i;
+	if (_objects.empty()) {
+		_buildCost = 0.0f;
+		return;
+	}
+
+	std::vector<glm::vec3> centers(_boxMin.size());
+	for (size_t i = 0; i < centers.size(); i++) centers[i] = 0.5f * (_boxMin[i] + _boxMax[i]);
+
+	// a binary tree with n leaves has 2n - 1 nodes, so the nodes never move while subdividing
+	_nodes.reserve(2 * _objects.size());
+	BVHNode root;
+	root.first = 0;
+	root.count = uint32_t(_objects.size());
+	_nodes.push_back(root);
+	updateLeaf(_nodes[0]);
+	subdivide(0, centers, 1);
+	_buildCost = cost();
+}
+
+void BVH::updateLeaf(BVHNode& node)
+{
+	node.min = _boxMin[_objects[node.first]];
+	node.max = _boxMax[_objects[node.first]];
+	for (uint32_t i = node.first + 1; i < node.first + node.count; i++) {
+		node.min = glm::min(node.min, _boxMin[_objects[i]]);
+		node.max = glm::max(node.max, _boxMax[_objects[i]]);
+	}
+}
+
+void BVH::subdivide(uint32_t nodeIndex, const std::vector<glm::vec3>& centers, size_t depth)
+{
+	const uint32_t first = _nodes[nodeIndex].first;
+	const uint32_t count = _nodes[nodeIndex].count;
+	if (count <= 1 || depth >= MAX_DEPTH) return;
+
+	glm::vec3 centerMin = centers[_objects[first]];
+	glm::vec3 centerMax = centerMin;
+	for (uint32_t i = first + 1; i < first + count; i++) {
+		centerMin = glm::min(centerMin, centers[_objects[i]]);
+		centerMax = glm::max(centerMax, centers[_objects[i]]);
+	}
+
+	// find the cheapest split plane between the bins of all three axes
+	int bestAxis = -1;
+	int bestPlane = 0;
+	float bestCost = 0.0f;
+	for (int axis = 0; axis < 3; axis++) {
+		float extent = centerMax[axis] - centerMin[axis];
+		if (extent <= 0.0f) continue;
+		float scale = float(BINS) / extent;
+
+		BVHBin bins[BINS];
+		for (BVHBin& bin : bins) {
+			bin.min = glm::vec3(FLT_MAX);
+			bin.max = glm::vec3(-FLT_MAX);
+			bin.count = 0;
+		}
+		for (uint32_t i = first; i < first + count; i++) {
+			uint32_t object = _objects[i];
+			int b = std::min(BINS - 1, int((centers[object][axis] - centerMin[axis]) * scale));
+			bins[b].min = glm::min(bins[b].min, _boxMin[object]);
+			bins[b].max = glm::max(bins[b].max, _boxMax[object]);
+			bins[b].count++;
+		}
+
+		// sweep from both sides, plane p splits bins [0, p) from [p, BINS)
+		float leftArea[BINS], rightArea[BINS];
+		uint32_t leftCount[BINS], rightCount[BINS];
+		glm::vec3 leftMin(FLT_MAX), leftMax(-FLT_MAX), rightMin(FLT_MAX), rightMax(-FLT_MAX);
+		uint32_t leftSum = 0, rightSum = 0;
+		for (int p = 1; p < BINS; p++) {
+			const BVHBin& left = bins[p - 1];
+			leftSum += left.count;
+			leftMin = glm::min(leftMin, left.min);
+			leftMax = glm::max(leftMax, left.max);
+			leftCount[p] = leftSum;
+			leftArea[p] = leftSum > 0 ? halfArea(leftMin, leftMax) : 0.0f;
+
+			const BVHBin& right = bins[BINS - p];
+			rightSum += right.count;
+			rightMin = glm::min(rightMin, right.min);
+			rightMax = glm::max(rightMax, right.max);
+			rightCount[BINS - p] = rightSum;
+			rightArea[BINS - p] = rightSum > 0 ? halfArea(rightMin, rightMax) : 0.0f;
+		}
+		for (int p = 1; p < BINS; p++) {
+			if (leftCount[p] == 0 || rightCount[p] == 0) continue;
+			float cost = leftArea[p] * float(leftCount[p]) + rightArea[p] * float(rightCount[p]);
+			if (bestAxis < 0 || cost < bestCost) {
+				bestAxis = axis;
+				bestPlane = p;
+				bestCost = cost;
+			}
+		}
+	}
+
+	uint32_t leftCount = 0;
+	if (bestAxis >= 0) {
+		// a small leaf stays a leaf if testing all its objects is cheaper than visiting two children
+		float area = halfArea(_nodes[nodeIndex].min, _nodes[nodeIndex].max);
+		float splitCost = 1.0f + (area > 0.0f ? bestCost / area : 0.0f);
+		if (count <= MAX_LEAF_SIZE && splitCost >= float(count)) return;
+
+		float scale = float(BINS) / (centerMax[bestAxis] - centerMin[bestAxis]);
+		uint32_t* middle = std::partition(&_objects[first], &_objects[first] + count, [&](uint32_t object) {
+			return std::min(BINS - 1, int((centers[object][bestAxis] - centerMin[bestAxis]) * scale)) < bestPlane;
+		});
+		leftCount = uint32_t(middle - &_objects[first]);
+	}
+	else {
+		// all centers in one point, no plane separates them
+		if (count <= MAX_LEAF_SIZE) return;
+		leftCount = count / 2;
+	}
+
+	uint32_t leftIndex = uint32_t(_nodes.size());
+	BVHNode child;
+	child.first = first;
+	child.count = leftCount;
+	_nodes.push_back(child);
+	child.first = first + leftCount;
+	child.count = count - leftCount;
+	_nodes.push_back(child);
+	updateLeaf(_nodes[leftIndex]);
+	updateLeaf(_nodes[leftIndex + 1]);
+
+	_nodes[nodeIndex].first = leftIndex;
+	_nodes[nodeIndex].count = 0;
+	subdivide(leftIndex, centers, depth + 1);
+	subdivide(leftIndex + 1, centers, depth + 1);
+}
+
+bool BVH::refit()
+{
+	// children are always stored after their parent
+	for (size_t i = _nodes.size(); i-- > 0;) {
+		BVHNode& node = _nodes[i];
+		if (node.isLeaf()) {
+			updateLeaf(node);
+		}
+		else {
+			node.min = glm::min(_nodes[node.first].min, _nodes[node.first + 1].min);
+			node.max = glm::max(_nodes[node.first].max, _nodes[node.first + 1].max);
+		}
+	}
+	return cost() > 2.0f * _buildCost;
+}
+
+float BVH::cost() const
+{
+	if (_nodes.empty()) return 0.0f;
+	float rootArea = halfArea(_nodes[0].min, _nodes[0].max);
+	if (rootArea <= 0.0f) return 0.0f;
+	float sum = 0.0f;
+	for (const BVHNode& node : _nodes) sum += halfArea(node.min, node.max) * (node.isLeaf() ? float(node.count) : 1.0f);
+	return sum / rootArea;
+}
+
+BVHStats BVH::getStats() const
+{
+	BVHStats stats = { _nodes.size(), 0, 0, cost() };
+	if (_nodes.empty()) return stats;
+	uint32_t stack[STACK_SIZE];
+	size_t depths[STACK_SIZE];
+	size_t top = 0;
+	stack[top] = 0;
+	depths[top++] = 1;
+	while (top > 0) {
+		top--;
+		const BVHNode& node = _nodes[stack[top]];
+		size_t depth = depths[top];
+		stats.depth = std::max(stats.depth, depth);
+		if (node.isLeaf()) {
+			stats.leaves++;
+			continue;
+		}
+		stack[top] = node.first;
+		depths[top++] = depth + 1;
+		stack[top] = node.first + 1;
+		depths[top++] = depth + 1;
+	}
+	return stats;
+}
+
+/* --------------------------------------------- */
+// Queries
+/* --------------------------------------------- */
+
+void BVH::collect(uint32_t nodeIndex, std::vector<uint32_t>& result) const
+{
+	const BVHNode& node = _nodes[nodeIndex];
+	if (node.isLeaf()) {
+		result.insert(result.end(), _objects.begin() + node.first, _objects.begin() + node.first + node.count);
+		return;
+	}
+	collect(node.first, result);
+	collect(node.first + 1, result);
+}
+
+void BVH::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& result) const
+{
+	if (_nodes.empty()) return;
+	uint32_t stack[STACK_SIZE];
+	size_t top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		uint32_t nodeIndex = stack[--top];
+		const BVHNode& node = _nodes[nodeIndex];
+		Frustum::Containment containment = frustum.containsBox(node.min, node.max);
+		if (containment == Frustum::OUTSIDE) continue;
+		if (containment == Frustum::INSIDE) {
+			collect(nodeIndex, result);
+		}
+		else if (node.isLeaf()) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				uint32_t object = _objects[i];
+				if (frustum.containsBox(_boxMin[object], _boxMax[object]) != Frustum::OUTSIDE) result.push_back(object);
+			}
+		}
+		else {
+			stack[top++] = node.first;
+			stack[top++] = node.first + 1;
+		}
+	}
+}
+
+void BVH::queryBox(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& result) const
+{
+	if (_nodes.empty()) return;
+	uint32_t stack[STACK_SIZE];
+	size_t top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const BVHNode& node = _nodes[stack[--top]];
+		if (!overlaps(node.min, node.max, min, max)) continue;
+		if (node.isLeaf()) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				uint32_t object = _objects[i];
+				if (overlaps(_boxMin[object], _boxMax[object], min, max)) result.push_back(object);
+			}
+		}
+		else {
+			stack[top++] = node.first;
+			stack[top++] = node.first + 1;
+		}
+	}
+}
+
+void BVH::querySegment(const glm::vec3& p0, const glm::vec3& p1, std::vector<uint32_t>& result) const
+{
+	if (_nodes.empty()) return;
+	glm::vec3 inverseDirection = 1.0f / (p1 - p0);
+	float distance;
+	uint32_t stack[STACK_SIZE];
+	size_t top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const BVHNode& node = _nodes[stack[--top]];
+		if (!intersectRay(node.min, node.max, p0, inverseDirection, 1.0f, distance)) continue;
+		if (node.isLeaf()) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				uint32_t object = _objects[i];
+				if (intersectRay(_boxMin[object], _boxMax[object], p0, inverseDirection, 1.0f, distance)) result.push_back(object);
+			}
+		}
+		else {
+			stack[top++] = node.first;
+			stack[top++] = node.first + 1;
+		}
+	}
+}
+
+int BVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const
+{
+	int hit = -1;
+	if (_nodes.empty()) return hit;
+	glm::vec3 inverseDirection = 1.0f / direction;
+	float entry;
+	if (!intersectRay(_nodes[0].min, _nodes[0].max, origin, inverseDirection, distance, entry)) return hit;
+
+	uint32_t stack[STACK_SIZE];
+	float entries[STACK_SIZE];
+	size_t top = 0;
+	stack[top] = 0;
+	entries[top++] = entry;
+	while (top > 0) {
+		top--;
+		// a closer hit was found after the node was pushed
+		if (entries[top] > distance) continue;
+		const BVHNode& node = _nodes[stack[top]];
+		if (node.isLeaf()) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				uint32_t object = _objects[i];
+				if (intersectRay(_boxMin[object], _boxMax[object], origin, inverseDirection, distance, entry)) {
+					distance = entry;
+					hit = int(object);
+				}
+			}
+			continue;
+		}
+
+		// push the far child first, so the near child is visited first
+		float entryLeft, entryRight;
+		bool hitLeft = intersectRay(_nodes[node.first].min, _nodes[node.first].max, origin, inverseDirection, distance, entryLeft);
+		bool hitRight = intersectRay(_nodes[node.first + 1].min, _nodes[node.first + 1].max, origin, inverseDirection, distance, entryRight);
+		if (hitLeft && hitRight) {
+			bool leftFirst = entryLeft <= entryRight;
+			stack[top] = leftFirst ? node.first + 1 : node.first;
+			entries[top++] = leftFirst ? entryRight : entryLeft;
+			stack[top] = leftFirst ? node.first : node.first + 1;
+			entries[top++] = leftFirst ? entryLeft : entryRight;
+		}
+		else if (hitLeft) {
+			stack[top] = node.first;
+			entries[top++] = entryLeft;
+		}
+		else if (hitRight) {
+			stack[top] = node.first + 1;
+			entries[top++] = entryRight;
+		}
+	}
+	return hit;
+}
+
+bool BVH::intersectRay(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance)
+{
+	glm::vec3 t0 = (min - origin) * inverseDirection;
+	glm::vec3 t1 = (max - origin) * inverseDirection;
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+	float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+	distance = enter;
+	return enter <= exit;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm\glm.hpp>
+#include "Culling.h"
+
+/*!
+ * One node of a BVH, 32 bytes
+ * Inner nodes have count 0 and their children at first and first + 1, leaves reference count objects from first on.
+ */
+struct BVHNode {
+	glm::vec3 min;
+	uint32_t first;
+	glm::vec3 max;
+	uint32_t count;
+
+	bool isLeaf() const { return count > 0; }
+};
+
+/*!
+ * Node count, depth and cost of a BVH
+ */
+struct BVHStats {
+	size_t nodes;
+	size_t leaves;
+	size_t depth;
+	/*!
+	 * Surface area heuristic cost relative to the root, lower is better
+	 */
+	float cost;
+};
+
+/*!
+ * Bounding volume hierarchy over the axis aligned boxes of scene objects
+ * Objects are identified by the index add() returned. The tree is built with a binned surface area heuristic.
+ * Static geometry builds the tree once. Moving objects update their boxes and refit the tree every frame, which keeps
+ * the structure and only grows the node boxes; once refit() reports that the tree degraded it has to be built again.
+ */
+class BVH
+{
+protected:
+	/*!
+	 * Maximum number of objects per leaf and number of bins per split
+	 */
+	static const uint32_t MAX_LEAF_SIZE = 4;
+	static const int BINS = 8;
+	/*!
+	 * Nodes this deep become leaves no matter how many objects they hold, which bounds the traversal stacks
+	 */
+	static const size_t MAX_DEPTH = 60;
+	static const size_t STACK_SIZE = 64;
+
+	std::vector<BVHNode> _nodes;
+	/*!
+	 * Object indices in leaf order
+	 */
+	std::vector<uint32_t> _objects;
+	std::vector<glm::vec3> _boxMin, _boxMax;
+	/*!
+	 * Cost right after the last build, refit() compares against it
+	 */
+	float _buildCost;
+
+	/*!
+	 * Sets the box of a node to the union of the boxes of its objects
+	 */
+	void updateLeaf(BVHNode& node);
+	/*!
+	 * Splits a leaf into two children if that lowers the cost, then splits the children
+	 * @param nodeIndex: index of the leaf
+	 * @param centers: box centers of all objects
+	 * @param depth: depth of the node
+	 */
+	void subdivide(uint32_t nodeIndex, const std::vector<glm::vec3>& centers, size_t depth);
+	/*!
+	 * @return the surface area heuristic cost of the tree relative to the root
+	 */
+	float cost() const;
+	/*!
+	 * Appends all objects below a node
+	 */
+	void collect(uint32_t nodeIndex, std::vector<uint32_t>& result) const;
+
+public:
+	BVH();
+
+	/*!
+	 * Removes all objects and nodes
+	 */
+	void clear();
+
+	/*!
+	 * Adds an object, the tree has to be built again before it is queried
+	 * @param min: minimum corner of the world space box
+	 * @param max: maximum corner of the world space box
+	 * @return the index of the object in query results
+	 */
+	uint32_t add(const glm::vec3& min, const glm::vec3& max);
+	/*!
+	 * Updates the box of an object, the tree has to be refitted or built before it is queried
+	 */
+	void update(uint32_t object, const glm::vec3& min, const glm::vec3& max);
+
+	/*!
+	 * Builds the tree from scratch
+	 */
+	void build();
+	/*!
+	 * Recomputes all node boxes bottom up after update(), without changing the structure
+	 * @return if the tree degraded to more than twice the cost after the last build and should be built again
+	 */
+	bool refit();
+
+	/*!
+	 * Appends all objects whose box is at least partly inside the frustum
+	 * Nodes completely inside the frustum add their objects without further tests.
+	 */
+	void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& result) const;
+	/*!
+	 * Appends all objects whose box intersects a box
+	 */
+	void queryBox(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& result) const;
+	/*!
+	 * Appends all objects whose box is hit by the line segment from p0 to p1
+	 */
+	void querySegment(const glm::vec3& p0, const glm::vec3& p1, std::vector<uint32_t>& result) const;
+	/*!
+	 * Finds the nearest object box hit by a ray, children are visited front to back
+	 * @param origin: origin of the ray
+	 * @param direction: direction of the ray, not necessarily normalized
+	 * @param distance: maximum distance in units of direction, receives the distance of the hit
+	 * @return the index of the object, -1 if no box was hit
+	 */
+	int raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+
+	/*!
+	 * @return the number of objects
+	 */
+	size_t size() const { return _boxMin.size(); }
+	/*!
+	 * @return the corners of the box of an object, as of the last add() or update()
+	 */
+	const glm::vec3& getMin(uint32_t object) const { return _boxMin[object]; }
+	const glm::vec3& getMax(uint32_t object) const { return _boxMax[object]; }
+	BVHStats getStats() const;
+
+	/*!
+	 * Tests a ray against a box with the slab method
+	 * @param origin: origin of the ray
+	 * @param inverseDirection: 1 / direction per component
+	 * @param maxDistance: hits further away are ignored
+	 * @param distance: receives the entry distance, 0 if the origin is inside
+	 * @return if the box is hit
+	 */
+	static bool intersectRay(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance);
+};
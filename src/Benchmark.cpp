@@ -0,0 +1,986 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <iostream>
+#include <glm/gtc/packing.hpp>
+#include "Geometry.h"
+#include "OBJLoader.h"
+#include "MeshOptimizer.h"
+#include "MeshCache.h"
+#include "DDSFile.h"
+#include "UniformId.h"
+#include "RenderQueue.h"
+#include "Culling.h"
+#include "BVH.h"
+#include "MeshSimplifier.h"
+#include "OcclusionBuffer.h"
+
+/* --------------------------------------------- */
+// Helpers
+/* --------------------------------------------- */
+
+static double secondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+/*!
+ * Lists all files with an extension in a directory and its subdirectories
+ */
+static void listFiles(const std::string& directory, const std::string& extension, std::vector<std::string>& files)
+{
+	WIN32_FIND_DATAA entry;
+	HANDLE find = FindFirstFileA((directory + "/*").c_str(), &entry);
+	if (find == INVALID_HANDLE_VALUE) return;
+	do {
+		std::string name = entry.cFileName;
+		if (name == "." || name == "..") continue;
+		if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			listFiles(directory + "/" + name, extension, files);
+		}
+		else if (name.size() >= extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0) {
+			files.push_back(directory + "/" + name);
+		}
+	} while (FindNextFileA(find, &entry));
+	FindClose(find);
+}
+
+/*!
+ * Creates the text of an OBJ grid mesh with the given number of triangles (rounded down to full quads)
+ */
+static std::string createSyntheticOBJ(size_t triangles)
+{
+	size_t quadsPerSide = size_t(std::sqrt(double(triangles / 2)));
+	size_t verticesPerSide = quadsPerSide + 1;
+
+	std::string text;
+	text.reserve(verticesPerSide * verticesPerSide * 80 + quadsPerSide * quadsPerSide * 80);
+	char line[128];
+	for (size_t y = 0; y < verticesPerSide; y++) {
+		for (size_t x = 0; x < verticesPerSide; x++) {
+			float u = float(x) / float(quadsPerSide), v = float(y) / float(quadsPerSide);
+			text.append(line, snprintf(line, sizeof(line), "v %f %f %f\n", u * 100.0f - 50.0f, 0.25f * std::sin(u * 40.0f), v * 100.0f - 50.0f));
+			text.append(line, snprintf(line, sizeof(line), "vt %f %f\n", u, v));
+		}
+	}
+	text.append("vn 0.000000 1.000000 0.000000\n");
+	for (size_t y = 0; y < quadsPerSide; y++) {
+		for (size_t x = 0; x < quadsPerSide; x++) {
+			size_t a = y * verticesPerSide + x + 1, b = a + 1, c = a + verticesPerSide, d = c + 1;
+			text.append(line, snprintf(line, sizeof(line), "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", a, a, c, c, b, b));
+			text.append(line, snprintf(line, sizeof(line), "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", b, b, c, c, d, d));
+		}
+	}
+	return text;
+}
+
+/* --------------------------------------------- */
+// Benchmarks
+/* --------------------------------------------- */
+
+/*!
+ * Parses ring.obj and a synthetic 1M triangle OBJ and reports the throughput
+ */
+static void benchmarkOBJLoader()
+{
+	std::cout << "***** OBJ loader *****\n\n";
+
+	MappedFile ring("assets/objects/ring.obj");
+	if (ring.isOpen()) {
+		const int runs = 50;
+		GeometryData data;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < runs; i++) OBJLoader::parse(ring.data(), ring.size(), data);
+		double seconds = secondsSince(start) / runs;
+		std::cout << "ring.obj: " << data.indices.size() / 3 << " triangles, " << seconds * 1000.0 << " ms, "
+			<< double(ring.size()) / (1024.0 * 1024.0) / seconds << " MB/s\n";
+	}
+
+	std::string synthetic = createSyntheticOBJ(1000000);
+	GeometryData data;
+	auto start = std::chrono::high_resolution_clock::now();
+	OBJLoader::parse(synthetic.data(), synthetic.size(), data);
+	double seconds = secondsSince(start);
+	std::cout << "synthetic: " << data.indices.size() / 3 << " triangles, " << seconds * 1000.0 << " ms, "
+		<< double(synthetic.size()) / (1024.0 * 1024.0) / seconds << " MB/s\n\n";
+}
+
+/*!
+ * Reports the vertex counts and buffer sizes of the shipped OBJs with and without vertex deduplication
+ */
+static void benchmarkVertexDeduplication()
+{
+	std::cout << "***** Vertex deduplication *****\n\n";
+
+	const char* paths[] = { "assets/objects/ring.obj", "assets/objects/testship.obj" };
+	for (const char* path : paths) {
+		GeometryData data;
+		if (!OBJLoader::load(path, data)) continue;
+
+		// without deduplication every corner was its own vertex with a 32 bit index
+		size_t corners = data.indices.size();
+		size_t bytesBefore = corners * (2 * sizeof(glm::vec3) + sizeof(glm::vec2) + sizeof(unsigned int));
+		std::cout << path << ": " << corners << " -> " << data.positions.size() << " vertices, "
+			<< bytesBefore << " -> " << data.byteSize() << " bytes"
+			<< (data.hasShortIndices() ? " (16 bit indices)" : " (32 bit indices)") << "\n";
+	}
+	std::cout << "\n";
+}
+
+/*!
+ * Reports the simulated vertex cache efficiency of the shipped OBJs and a synthetic grid before and after optimization
+ */
+static void benchmarkMeshOptimizer()
+{
+	std::cout << "***** Mesh optimizer (ACMR / ATVR, FIFO 16 / 32) *****\n\n";
+
+	std::vector<std::pair<std::string, GeometryData>> meshes;
+	const char* paths[] = { "assets/objects/ring.obj", "assets/objects/testship.obj" };
+	for (const char* path : paths) {
+		GeometryData data;
+		if (OBJLoader::load(path, data)) meshes.push_back(std::make_pair(std::string(path), std::move(data)));
+	}
+	std::string grid = createSyntheticOBJ(100000);
+	GeometryData gridData;
+	OBJLoader::parse(grid.data(), grid.size(), gridData);
+	meshes.push_back(std::make_pair(std::string("synthetic grid"), std::move(gridData)));
+
+	for (auto& mesh : meshes) {
+		VertexCacheStats before16 = MeshOptimizer::analyzeVertexCache(mesh.second, 16);
+		VertexCacheStats before32 = MeshOptimizer::analyzeVertexCache(mesh.second, 32);
+		auto start = std::chrono::high_resolution_clock::now();
+		MeshOptimizer::optimize(mesh.second);
+		double seconds = secondsSince(start);
+		VertexCacheStats after16 = MeshOptimizer::analyzeVertexCache(mesh.second, 16);
+		VertexCacheStats after32 = MeshOptimizer::analyzeVertexCache(mesh.second, 32);
+		std::cout << mesh.first << " (" << seconds * 1000.0 << " ms):\n"
+			<< "  before: " << before16.acmr << " / " << before16.atvr << ", " << before32.acmr << " / " << before32.atvr << "\n"
+			<< "  after:  " << after16.acmr << " / " << after16.atvr << ", " << after32.acmr << " / " << after32.atvr << "\n";
+	}
+	std::cout << "\n";
+}
+
+/*!
+ * Compares loading all shipped OBJs from text with loading their binary mesh caches
+ * Cold: no cache exists, the OBJ is parsed and the cache is written. Warm: the cache is mapped.
+ */
+static void benchmarkMeshCache()
+{
+	std::cout << "***** Mesh cache (text / cold cache / warm cache) *****\n\n";
+
+	const char* paths[] = { "assets/objects/ring.obj", "assets/objects/testship.obj", "assets/objects/test.obj" };
+	for (const char* path : paths) {
+		auto start = std::chrono::high_resolution_clock::now();
+		GeometryData data = Geometry::createOBJGeometry(path);
+		std::vector<InterleavedVertex> vertices = data.interleave();
+		double textSeconds = secondsSince(start);
+
+		DeleteFileA(MeshCache::cachePath(path).c_str());
+		start = std::chrono::high_resolution_clock::now();
+		bool cold = MeshCache::load(path)->isValid();
+		double coldSeconds = secondsSince(start);
+
+		// touch every byte, as the upload would
+		start = std::chrono::high_resolution_clock::now();
+		std::unique_ptr<MeshCacheFile> cache = MeshCache::load(path);
+		unsigned int checksum = 0;
+		if (cache->isValid()) {
+			const unsigned char* bytes = static_cast<const unsigned char*>(cache->vertexData());
+			for (size_t i = 0; i < cache->vertexDataSize() + cache->indexDataSize(); i++) checksum += bytes[i];
+		}
+		double warmSeconds = secondsSince(start);
+
+		std::cout << path << ": " << textSeconds * 1000.0 << " ms / "
+			<< coldSeconds * 1000.0 << " ms / " << warmSeconds * 1000.0 << " ms"
+			<< (cold && cache->isValid() ? "" : " (cache failed)") << " [" << checksum << "]\n";
+	}
+	std::cout << "\n";
+}
+
+/*!
+ * Checks that quantized vertices decode to the original attributes within fixed error bounds
+ */
+static void benchmarkVertexQuantization()
+{
+	std::cout << "***** Vertex quantization round trip *****\n\n";
+
+	const float maxNormalError = 1e-4f;
+	const float maxUVError = 1e-3f;
+
+	std::vector<std::pair<std::string, GeometryData>> meshes;
+	meshes.push_back(std::make_pair(std::string("ring.obj"), Geometry::createOBJGeometry("assets/objects/ring.obj")));
+	meshes.push_back(std::make_pair(std::string("sphere 64x32"), Geometry::createSphereGeometry(64, 32, 1.0f)));
+	meshes.push_back(std::make_pair(std::string("cylinder 32"), Geometry::createCylinderGeometry(32, 1.3f, 1.0f)));
+
+	for (auto& mesh : meshes) {
+		const GeometryData& data = mesh.second;
+		glm::vec3 offset, scale;
+		std::vector<QuantizedVertex> vertices = data.quantize(offset, scale);
+		// half a quantization step, plus float rounding
+		float maxPositionError = 0.5f * glm::max(scale.x, glm::max(scale.y, scale.z)) / 65535.0f + 1e-5f;
+
+		float positionError = 0.0f, normalError = 0.0f, uvError = 0.0f;
+		for (size_t i = 0; i < vertices.size(); i++) {
+			const QuantizedVertex& v = vertices[i];
+			glm::vec3 position = offset + scale * glm::vec3(
+				glm::unpackUnorm1x16(v.position[0]), glm::unpackUnorm1x16(v.position[1]), glm::unpackUnorm1x16(v.position[2]));
+			glm::vec3 normal = octahedralDecode(glm::vec2(
+				glm::unpackSnorm1x16(glm::uint16(v.normal[0])), glm::unpackSnorm1x16(glm::uint16(v.normal[1]))));
+			glm::vec2 uv = glm::vec2(glm::unpackHalf1x16(v.uv[0]), glm::unpackHalf1x16(v.uv[1]));
+
+			glm::vec3 d = glm::abs(position - data.positions[i]);
+			positionError = glm::max(positionError, glm::max(d.x, glm::max(d.y, d.z)));
+			normalError = glm::max(normalError, glm::length(normal - glm::normalize(data.normals[i])));
+			glm::vec2 e = glm::abs(uv - data.UVs[i]);
+			uvError = glm::max(uvError, glm::max(e.x, e.y));
+		}
+
+		bool passed = positionError <= maxPositionError && normalError <= maxNormalError && uvError <= maxUVError;
+		std::cout << mesh.first << ": " << sizeof(InterleavedVertex) << " -> " << sizeof(QuantizedVertex) << " bytes/vertex, "
+			<< "max error position " << positionError << " (bound " << maxPositionError << "), "
+			<< "normal " << normalError << " (bound " << maxNormalError << "), "
+			<< "uv " << uvError << " (bound " << maxUVError << ") " << (passed ? "PASSED" : "FAILED") << "\n";
+	}
+	std::cout << "\n";
+}
+
+/*!
+ * Measures the per-draw CPU cost of the normal matrix for 10k static objects
+ */
+static void benchmarkNormalMatrices()
+{
+	std::cout << "***** Normal matrices, 10k static objects *****\n\n";
+
+	const int objectCount = 10000;
+	const int frames = 100;
+	std::vector<Geometry> objects;
+	objects.reserve(objectCount);
+	for (int i = 0; i < objectCount; i++) {
+		// rigid transforms with uniform scale, every fourth object with a non-uniform scale
+		glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(float(i % 100), float(i / 100), -float(i % 7)));
+		modelMatrix = glm::rotate(modelMatrix, float(i) * 0.37f, glm::normalize(glm::vec3(1.0f, float(i % 5), 2.0f)));
+		modelMatrix = glm::scale(modelMatrix, i % 4 == 0 ? glm::vec3(1.0f, 2.0f, 0.5f) : glm::vec3(1.0f + float(i % 3)));
+		objects.push_back(Geometry(modelMatrix, std::shared_ptr<Mesh>(), std::shared_ptr<Material>()));
+	}
+
+	float checksum = 0.0f;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		for (const Geometry& object : objects) checksum += glm::mat3(glm::transpose(glm::inverse(object.getModelMatrix())))[0][0];
+	}
+	double inverseSeconds = secondsSince(start) / frames;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		for (const Geometry& object : objects) checksum += Geometry::computeNormalMatrix(object.getModelMatrix())[0][0];
+	}
+	double fastSeconds = secondsSince(start) / frames;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		for (const Geometry& object : objects) checksum += object.getNormalMatrix()[0][0];
+	}
+	double cachedSeconds = secondsSince(start) / frames;
+
+	float maxError = 0.0f;
+	for (const Geometry& object : objects) {
+		glm::mat3 expected = glm::mat3(glm::transpose(glm::inverse(object.getModelMatrix())));
+		glm::mat3 actual = object.getNormalMatrix();
+		for (int c = 0; c < 3; c++) {
+			glm::vec3 d = glm::abs(actual[c] - expected[c]);
+			maxError = glm::max(maxError, glm::max(d.x, glm::max(d.y, d.z)));
+		}
+	}
+
+	std::cout << "inverse every draw:   " << inverseSeconds * 1000.0 << " ms/frame (" << inverseSeconds * 1e9 / objectCount << " ns/object)\n";
+	std::cout << "fast inverse (dirty): " << fastSeconds * 1000.0 << " ms/frame (" << fastSeconds * 1e9 / objectCount << " ns/object)\n";
+	std::cout << "cached (static):      " << cachedSeconds * 1000.0 << " ms/frame (" << cachedSeconds * 1e9 / objectCount << " ns/object)\n";
+	std::cout << "max error " << maxError << " " << (maxError <= 1e-4f ? "PASSED" : "FAILED") << " [" << checksum << "]\n\n";
+}
+
+/*!
+ * Validates the header parsing and mip level offsets of every DDS file in assets/textures
+ */
+static void benchmarkDDSFiles()
+{
+	std::cout << "***** DDS files *****\n\n";
+
+	std::vector<std::string> files;
+	listFiles("assets/textures", ".dds", files);
+	for (const std::string& path : files) {
+		auto start = std::chrono::high_resolution_clock::now();
+		DDSFile dds(path);
+		double seconds = secondsSince(start);
+
+		// the levels have to follow each other without gaps, halve in size and end exactly at the end of the file
+		bool passed = dds.isValid();
+		size_t expectedOffset = dds.getHeaderSize();
+		for (unsigned int face = 0; passed && face < dds.getFaces(); face++) {
+			for (unsigned int level = 0; passed && level < dds.getMipLevels(); level++) {
+				const DDSLevel& l = dds.getLevel(face, level);
+				unsigned int width = std::max(dds.getWidth() >> level, 1u);
+				unsigned int height = std::max(dds.getHeight() >> level, 1u);
+				size_t size = size_t((width + 3) / 4) * ((height + 3) / 4) * dds.getBlockSize();
+				passed = l.offset == expectedOffset && l.width == width && l.height == height && l.size == size;
+				expectedOffset += l.size;
+			}
+		}
+		passed = passed && expectedOffset == dds.getFileSize();
+
+		std::cout << path << ": " << dds.getWidth() << "x" << dds.getHeight() << ", " << dds.getMipLevels() << " mip levels, "
+			<< dds.getFaces() << (dds.getFaces() == 1 ? " face, " : " faces, ") << "format 0x" << std::hex << dds.getFormat() << std::dec
+			<< ", " << seconds * 1000.0 << " ms " << (passed ? "PASSED" : "FAILED") << "\n";
+	}
+	std::cout << "\n";
+}
+
+/*!
+ * Uniforms set per object by Geometry, Mesh and TextureMaterial
+ */
+static const char* const OBJECT_UNIFORMS[] = {
+	"modelMatrix", "normalMatrix", "instanced", "quantized", "positionOffset", "positionScale",
+	"illumination", "specularAlpha", "diffuseTexture", "diffuseTextureArray", "diffuseLayer"
+};
+
+/*!
+ * The name lookup of Shader::setUniform(std::string, ...), which passes the name by value to getUniformLocation
+ */
+static GLint getLocationByName(std::unordered_map<std::string, GLint>& locations, std::string uniform)
+{
+	auto it = locations.find(uniform);
+	if (it != locations.end()) return it->second;
+	GLint location = GLint(locations.size());
+	locations[uniform] = location;
+	return location;
+}
+
+static GLint setUniformByName(std::unordered_map<std::string, GLint>& locations, std::string uniform)
+{
+	return getLocationByName(locations, uniform);
+}
+
+/*!
+ * Answers location queries without an OpenGL context
+ */
+static GLint APIENTRY benchmarkGetUniformLocation(GLuint program, const GLchar* name)
+{
+	return GLint(std::string(name).size());
+}
+
+/*!
+ * Stands in for a later program that was given the handle of a deleted one and has none of its uniforms
+ */
+static GLint APIENTRY benchmarkGetReusedUniformLocation(GLuint program, const GLchar* name)
+{
+	return -1;
+}
+
+/*!
+ * Counts heap allocations and measures the time of the uniform location lookups of 1k objects per frame,
+ * by name as in Shader::setUniform(std::string, ...) and by interned UniformId
+ */
+static void benchmarkUniformLookups()
+{
+	std::cout << "***** Uniform lookups, 1k objects *****\n\n";
+
+	const int objectCount = 1000;
+	const int frames = 100;
+	const size_t objectUniforms = sizeof(OBJECT_UNIFORMS) / sizeof(OBJECT_UNIFORMS[0]);
+
+	std::unordered_map<std::string, GLint> locations;
+	long long checksum = 0;
+	size_t allocations = getHeapAllocationCount();
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		for (int object = 0; object < objectCount; object++) {
+			for (size_t u = 0; u < objectUniforms; u++) checksum += setUniformByName(locations, OBJECT_UNIFORMS[u]);
+		}
+	}
+	double nameSeconds = secondsSince(start) / frames;
+	double nameAllocations = double(getHeapAllocationCount() - allocations) / frames;
+
+	// the ids are static constants at the call sites, their locations are queried once per program
+	std::vector<UniformId> objectIds;
+	for (size_t u = 0; u < objectUniforms; u++) objectIds.push_back(UniformId(OBJECT_UNIFORMS[u]));
+	PFNGLGETUNIFORMLOCATIONPROC getUniformLocation = glGetUniformLocation;
+	glGetUniformLocation = benchmarkGetUniformLocation;
+	const GLuint program = 1;
+	for (const UniformId& id : objectIds) checksum += id.getLocation(program);
+
+	allocations = getHeapAllocationCount();
+	start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		for (int object = 0; object < objectCount; object++) {
+			for (const UniformId& id : objectIds) checksum += id.getLocation(program);
+		}
+	}
+	double idSeconds = secondsSince(start) / frames;
+	double idAllocations = double(getHeapAllocationCount() - allocations) / frames;
+
+	// the handle of a deleted program is reused, the locations of the old program must not be returned
+	UniformId::forget(program);
+	glGetUniformLocation = benchmarkGetReusedUniformLocation;
+	bool reused = true;
+	for (const UniformId& id : objectIds) reused = reused && id.getLocation(program) == -1;
+	UniformId::forget(program);
+	glGetUniformLocation = getUniformLocation;
+
+	std::cout << "by name:       " << nameSeconds * 1000.0 << " ms/frame, " << nameAllocations << " heap allocations/frame\n";
+	std::cout << "by UniformId:  " << idSeconds * 1000.0 << " ms/frame, " << idAllocations << " heap allocations/frame\n";
+	std::cout << "reused program handle: " << (reused ? "locations queried again" : "stale locations") << "\n";
+	std::cout << (idAllocations == 0.0 && reused ? "PASSED" : "FAILED") << " [" << checksum << "]\n\n";
+}
+
+/*!
+ * Records the command stream of a synthetic frame of 10k objects without an OpenGL context,
+ * validates it by replaying the state changes and compares the state changes with drawing in submission order
+ */
+static void benchmarkRenderQueue()
+{
+	std::cout << "***** Render queue, 10k objects *****\n\n";
+
+	const uint32_t objectCount = 10000;
+	const uint32_t shaderCount = 4, textureCount = 16, materialCount = 64, meshCount = 32;
+
+	for (int instancing = 0; instancing < 2; instancing++) {
+		RenderQueue queue(instancing != 0);
+		queue.begin(glm::vec3(0.0f), 1.0f);
+		uint32_t random = 12345;
+		for (uint32_t i = 0; i < objectCount; i++) {
+			random = random * 1664525u + 1013904223u;
+			uint32_t material = (random >> 8) % materialCount;
+			random = random * 1664525u + 1013904223u;
+			RenderItem item;
+			item.shader = material % shaderCount + 1;
+			// every eighth material has no texture, the others share textures
+			item.texture = material % 8 == 0 ? 0 : material % textureCount + 1;
+			item.material = material + 1;
+			item.mesh = (random >> 8) % meshCount + 1;
+			item.geometry = nullptr;
+			item.key = RenderQueue::makeKey(0, item.shader, item.texture, item.material, item.mesh, float(random % 1000) / 1000.0f);
+			queue.submit(item);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		queue.sort();
+		const std::vector<RenderCommand>& commands = queue.record();
+		double seconds = secondsSince(start);
+
+		// replay: every draw has to see the state of its items, every item has to be drawn once
+		const std::vector<RenderItem>& items = queue.getItems();
+		std::vector<int> drawn(items.size(), 0);
+		uint32_t shader = 0, texture = 0, material = 0, mesh = 0;
+		bool passed = true;
+		for (const RenderCommand& command : commands) {
+			const RenderItem& item = items[command.item];
+			switch (command.type) {
+			case RenderCommandType::USE_PROGRAM: shader = item.shader; material = 0; mesh = 0; break;
+			case RenderCommandType::BIND_TEXTURE: texture = item.texture; break;
+			case RenderCommandType::SET_MATERIAL: material = item.material; break;
+			case RenderCommandType::BIND_MESH: mesh = item.mesh; break;
+			case RenderCommandType::DRAW:
+			case RenderCommandType::DRAW_INSTANCED:
+				for (uint32_t i = command.item; i < command.item + command.count; i++) {
+					const RenderItem& drawItem = items[i];
+					if (drawItem.shader != shader || drawItem.material != material || drawItem.mesh != mesh) passed = false;
+					if (drawItem.texture != 0 && drawItem.texture != texture) passed = false;
+					drawn[i]++;
+				}
+				break;
+			}
+		}
+		for (int count : drawn) if (count != 1) passed = false;
+
+		const RenderQueueStats& stats = queue.getStats();
+		std::cout << (instancing ? "instancing:    " : "no instancing: ") << stats.drawCalls << " draw calls, "
+			<< stats.programChanges << " program changes, " << stats.materialChanges << " material changes, "
+			<< stats.textureBinds << " texture binds, " << stats.meshBinds << " mesh binds (unsorted: "
+			<< stats.objects << " each), sort and record " << seconds * 1000.0 << " ms " << (passed ? "PASSED" : "FAILED") << "\n";
+	}
+	std::cout << "\n";
+}
+
+/*!
+ * Culls 100k random bounding spheres against a view frustum, compares the SoA culler with testing one sphere at a time
+ * and checks that objects behind the camera or beyond the far plane are rejected
+ */
+static void benchmarkFrustumCulling()
+{
+	std::cout << "***** Frustum culling, 100k spheres *****\n\n";
+
+	// the default camera of the game, looking down -z
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 6.0f), glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = Frustum::fromMatrix(projection * view);
+
+	const size_t sphereCount = 100000;
+	const int frames = 100;
+	std::vector<glm::vec4> spheres(sphereCount);
+	SphereCuller culler;
+	culler.reserve(sphereCount);
+	uint32_t random = 12345;
+	for (glm::vec4& sphere : spheres) {
+		float values[4];
+		for (float& value : values) {
+			random = random * 1664525u + 1013904223u;
+			value = float(random >> 8) / float(1 << 24);
+		}
+		sphere = glm::vec4(values[0] * 300.0f - 150.0f, values[1] * 300.0f - 150.0f, values[2] * 300.0f - 150.0f, values[3] * 2.0f);
+		culler.add(sphere);
+	}
+
+	size_t checksum = 0;
+	std::vector<unsigned char> visible;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) checksum += culler.cull(frustum, visible);
+	double soaSeconds = secondsSince(start) / frames;
+
+	std::vector<unsigned char> expected(sphereCount);
+	start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		for (size_t i = 0; i < sphereCount; i++) {
+			expected[i] = frustum.containsSphere(glm::vec3(spheres[i]), spheres[i].w) ? 1 : 0;
+			checksum += expected[i];
+		}
+	}
+	double singleSeconds = secondsSince(start) / frames;
+
+	size_t visibleCount = 0;
+	bool passed = visible == expected;
+	for (unsigned char v : visible) visibleCount += v;
+
+	std::cout << "one sphere at a time: " << singleSeconds * 1000.0 << " ms/frame (" << singleSeconds * 1e9 / sphereCount << " ns/sphere)\n";
+	std::cout << "SoA culler:           " << soaSeconds * 1000.0 << " ms/frame (" << soaSeconds * 1e9 / sphereCount << " ns/sphere)\n";
+	std::cout << visibleCount << " of " << sphereCount << " visible, results " << (passed ? "match PASSED" : "differ FAILED") << " [" << checksum << "]\n";
+
+	// objects behind the camera, beyond the far plane and straddling the near plane
+	struct Case { const char* name; glm::vec4 sphere; bool visible; };
+	const Case cases[] = {
+		{ "in front", glm::vec4(0.0f, 0.0f, -10.0f, 1.0f), true },
+		{ "behind", glm::vec4(0.0f, 0.0f, 10.0f, 1.0f), false },
+		{ "behind, large", glm::vec4(0.0f, 0.0f, 30.0f, 20.0f), false },
+		{ "behind, touching near plane", glm::vec4(0.0f, 0.0f, 7.0f, 1.5f), true },
+		{ "beyond far", glm::vec4(0.0f, 0.0f, -100.0f, 1.0f), false },
+		{ "left of view", glm::vec4(-100.0f, 0.0f, -10.0f, 1.0f), false }
+	};
+	culler.clear();
+	for (const Case& c : cases) culler.add(c.sphere);
+	culler.cull(frustum, visible);
+	bool casesPassed = true;
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		bool single = frustum.containsSphere(glm::vec3(cases[i].sphere), cases[i].sphere.w);
+		if ((visible[i] != 0) != cases[i].visible || single != cases[i].visible) {
+			std::cout << cases[i].name << ": expected " << (cases[i].visible ? "visible" : "culled") << "\n";
+			casesPassed = false;
+		}
+	}
+	std::cout << "objects behind the camera rejected " << (casesPassed ? "PASSED" : "FAILED") << "\n\n";
+}
+
+/*!
+ * Builds, refits and queries a BVH over 1k, 10k and 100k random boxes
+ * and checks the frustum, ray and segment queries against testing every box
+ */
+static void benchmarkBVH()
+{
+	std::cout << "***** Bounding volume hierarchy *****\n\n";
+
+	for (size_t objectCount : { size_t(1000), size_t(10000), size_t(100000) }) {
+		// the same density for every count
+		float side = 10.0f * std::cbrt(float(objectCount));
+		uint32_t random = 12345;
+		auto next = [&random]() {
+			random = random * 1664525u + 1013904223u;
+			return float(random >> 8) / float(1 << 24);
+		};
+		std::vector<glm::vec3> boxMin(objectCount), boxMax(objectCount);
+		for (size_t i = 0; i < objectCount; i++) {
+			glm::vec3 center = glm::vec3(next(), next(), next()) * side - 0.5f * side;
+			glm::vec3 extent = glm::vec3(0.5f + next(), 0.5f + next(), 0.5f + next());
+			boxMin[i] = center - extent;
+			boxMax[i] = center + extent;
+		}
+
+		BVH tree;
+		for (size_t i = 0; i < objectCount; i++) tree.add(boxMin[i], boxMax[i]);
+		auto start = std::chrono::high_resolution_clock::now();
+		tree.build();
+		double buildSeconds = secondsSince(start);
+		BVHStats stats = tree.getStats();
+
+		// every object moves a bit, like the obstacles between two frames
+		for (size_t i = 0; i < objectCount; i++) {
+			glm::vec3 offset = glm::vec3(next(), next(), next()) - 0.5f;
+			boxMin[i] += offset;
+			boxMax[i] += offset;
+			tree.update(uint32_t(i), boxMin[i], boxMax[i]);
+		}
+		start = std::chrono::high_resolution_clock::now();
+		bool degraded = tree.refit();
+		double refitSeconds = secondsSince(start);
+		float refitCost = tree.getStats().cost;
+
+		// frustum from the center of the scene, half of the scene in view
+		glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 0.5f * side)
+			* glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		Frustum frustum = Frustum::fromMatrix(viewProjection);
+		const int queries = 20;
+		std::vector<uint32_t> visible, expected;
+		start = std::chrono::high_resolution_clock::now();
+		for (int q = 0; q < queries; q++) {
+			visible.clear();
+			tree.queryFrustum(frustum, visible);
+		}
+		double frustumSeconds = secondsSince(start) / queries;
+		start = std::chrono::high_resolution_clock::now();
+		for (int q = 0; q < queries; q++) {
+			expected.clear();
+			for (uint32_t i = 0; i < objectCount; i++) {
+				if (frustum.containsBox(boxMin[i], boxMax[i]) != Frustum::OUTSIDE) expected.push_back(i);
+			}
+		}
+		double linearSeconds = secondsSince(start) / queries;
+		std::sort(visible.begin(), visible.end());
+		bool passed = visible == expected;
+
+		// rays for picking and segments for ring passes, through the scene
+		const int rays = 1000;
+		std::vector<glm::vec3> origins(rays), directions(rays);
+		for (int r = 0; r < rays; r++) {
+			origins[r] = glm::vec3(next(), next(), next()) * side - 0.5f * side;
+			directions[r] = (glm::vec3(next(), next(), next()) - 0.5f) * side;
+		}
+		std::vector<float> hitDistances(rays);
+		start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < rays; r++) {
+			hitDistances[r] = 1.0f;
+			if (tree.raycast(origins[r], directions[r], hitDistances[r]) < 0) hitDistances[r] = -1.0f;
+		}
+		double raySeconds = secondsSince(start) / rays;
+		start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < rays; r++) {
+			glm::vec3 inverseDirection = 1.0f / directions[r];
+			float nearest = 1.0f, distance;
+			bool hit = false;
+			for (size_t i = 0; i < objectCount; i++) {
+				if (BVH::intersectRay(boxMin[i], boxMax[i], origins[r], inverseDirection, nearest, distance)) {
+					nearest = distance;
+					hit = true;
+				}
+			}
+			if ((hit ? nearest : -1.0f) != hitDistances[r]) passed = false;
+		}
+		double bruteRaySeconds = secondsSince(start) / rays;
+
+		// short segments, as the ship moves between two frames
+		std::vector<uint32_t> segmentHits;
+		size_t segmentHitCount = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < rays; r++) {
+			segmentHits.clear();
+			tree.querySegment(origins[r], origins[r] + 0.05f * directions[r], segmentHits);
+			segmentHitCount += segmentHits.size();
+		}
+		double segmentSeconds = secondsSince(start) / rays;
+		size_t expectedSegmentHits = 0;
+		for (int r = 0; r < rays; r++) {
+			glm::vec3 inverseDirection = 1.0f / (0.05f * directions[r]);
+			float distance;
+			for (size_t i = 0; i < objectCount; i++) {
+				if (BVH::intersectRay(boxMin[i], boxMax[i], origins[r], inverseDirection, 1.0f, distance)) expectedSegmentHits++;
+			}
+		}
+		if (segmentHitCount != expectedSegmentHits) passed = false;
+
+		std::cout << objectCount << " objects: " << stats.nodes << " nodes, depth " << stats.depth << ", cost " << stats.cost
+			<< " (after refit " << refitCost << (degraded ? ", rebuild" : "") << ")\n";
+		std::cout << "build " << buildSeconds * 1000.0 << " ms, refit " << refitSeconds * 1000.0 << " ms\n";
+		std::cout << "frustum " << frustumSeconds * 1000.0 << " ms (every box " << linearSeconds * 1000.0 << " ms), "
+			<< visible.size() << " visible\n";
+		std::cout << "ray " << raySeconds * 1e6 << " us (every box " << bruteRaySeconds * 1e6 << " us), segment "
+			<< segmentSeconds * 1e6 << " us " << (passed ? "PASSED" : "FAILED") << "\n\n";
+	}
+}
+
+/*!
+ * Counts the edges of a mesh, welded by position, that are not shared by exactly two triangles
+ */
+static size_t countOpenEdges(const GeometryData& data)
+{
+	std::unordered_map<std::string, int> edges;
+	for (size_t i = 0; i + 2 < data.indices.size(); i += 3) {
+		for (int e = 0; e < 3; e++) {
+			glm::vec3 a = data.positions[data.indices[i + e]], b = data.positions[data.indices[i + (e + 1) % 3]];
+			if (b.x < a.x || (b.x == a.x && (b.y < a.y || (b.y == a.y && b.z < a.z)))) std::swap(a, b);
+			edges[std::string(reinterpret_cast<const char*>(&a), sizeof(a)) + std::string(reinterpret_cast<const char*>(&b), sizeof(b))]++;
+		}
+	}
+	size_t open = 0;
+	for (const auto& edge : edges) {
+		if (edge.second != 2) open++;
+	}
+	return open;
+}
+
+/*!
+ * Simplifies the sphere, ring.obj and a large synthetic grid to coarser levels of detail, each from the one before
+ * and checks the triangle counts, that closed meshes stay closed and that the sphere keeps its shape,
+ * then checks that the level of detail selection does not flicker around a switch distance
+ */
+static void benchmarkMeshSimplifier()
+{
+	std::cout << "***** Mesh simplifier *****\n\n";
+
+	struct Source { const char* name; GeometryData data; bool closed; bool sphere; };
+	std::vector<Source> sources;
+	sources.push_back({ "sphere", Geometry::createSphereGeometry(64, 32, 1.0f), true, true });
+	// read back from the mesh cache, as MeshRegistry::loadLODs does
+	GeometryData ring = MeshCache::load("assets/objects/ring.obj")->toGeometryData();
+	if (!ring.indices.empty()) sources.push_back({ "ring.obj", ring, true, false });
+	{
+		std::string synthetic = createSyntheticOBJ(100000);
+		GeometryData data;
+		if (OBJLoader::parse(synthetic.data(), synthetic.size(), data)) {
+			MeshOptimizer::optimize(data);
+			sources.push_back({ "synthetic", data, false, false });
+		}
+	}
+
+	bool passed = true;
+	for (const Source& source : sources) {
+		size_t triangles = source.data.indices.size() / 3;
+		size_t openEdges = countOpenEdges(source.data);
+		// every level simplifies the one before, so the errors of the levels add up
+		GeometryData data = source.data;
+		for (size_t level = 1; level <= 3; level++) {
+			size_t target = data.indices.size() / 3 / 2;
+			auto start = std::chrono::high_resolution_clock::now();
+			float error = MeshSimplifier::simplify(data, target);
+			double seconds = secondsSince(start);
+
+			bool levelPassed = data.indices.size() / 3 <= target && data.indices.size() % 3 == 0;
+			if (source.closed) levelPassed = levelPassed && countOpenEdges(data) == openEdges;
+			if (source.sphere) {
+				for (size_t i = 0; i < data.indices.size(); i += 3) {
+					glm::vec3 a = data.positions[data.indices[i]], b = data.positions[data.indices[i + 1]], c = data.positions[data.indices[i + 2]];
+					if (glm::dot(glm::cross(b - a, c - a), a + b + c) <= 0.0f) levelPassed = false;
+				}
+				for (const glm::vec3& position : data.positions) {
+					if (std::abs(glm::length(position) - 1.0f) > 1e-4f) levelPassed = false;
+				}
+			}
+			passed = passed && levelPassed;
+			std::cout << source.name << ": " << triangles << " -> " << data.indices.size() / 3 << " triangles (target " << target
+				<< "), error " << error << ", " << seconds * 1000.0 << " ms " << (levelPassed ? "PASSED" : "FAILED") << "\n";
+		}
+	}
+
+	// sweep the screen size down and up, then hold it around each switch point
+	const size_t levels = 4;
+	bool monotonic = true, stable = true;
+	size_t lod = 0;
+	for (float size = 1.0f; size > 0.001f; size *= 0.97f) {
+		size_t next = Geometry::selectLOD(lod, levels, size);
+		if (next < lod) monotonic = false;
+		lod = next;
+	}
+	if (lod != levels - 1) monotonic = false;
+	for (float size = 0.001f; size < 1.0f; size *= 1.03f) {
+		size_t next = Geometry::selectLOD(lod, levels, size);
+		if (next > lod) monotonic = false;
+		lod = next;
+	}
+	if (lod != 0) monotonic = false;
+	for (size_t level = 1; level < levels; level++) {
+		float threshold = 0.25f / float(1 << (level - 1));
+		lod = Geometry::selectLOD(level - 1, levels, threshold);
+		size_t first = lod;
+		for (int frame = 0; frame < 100; frame++) {
+			lod = Geometry::selectLOD(lod, levels, threshold * (frame % 2 ? 1.05f : 0.95f));
+			if (lod != first) stable = false;
+		}
+	}
+	std::cout << "level of detail selection " << (monotonic ? "monotonic" : "not monotonic") << ", "
+		<< (stable ? "no flicker at switch points" : "flickers at switch points") << " "
+		<< (passed && monotonic && stable ? "PASSED" : "FAILED") << "\n\n";
+}
+
+/*!
+ * Ground truth of the occlusion test: casts a ray through every pixel center the box covers on screen
+ * and compares the depth where it enters the box with the rasterized depth
+ * @return if the box is in front of the occluders at any pixel center (within depth precision)
+ */
+static bool isBoxVisibleAtPixels(const OcclusionBuffer& buffer, const glm::mat4& viewProjection, const glm::vec3& min, const glm::vec3& max)
+{
+	glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+	glm::vec2 rectMin = glm::vec2(1.0f), rectMax = glm::vec2(-1.0f);
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec4 clip = viewProjection * glm::vec4(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z, 1.0f);
+		if (clip.w <= 0.0f) return true;
+		rectMin = glm::min(rectMin, glm::vec2(clip) / clip.w);
+		rectMax = glm::max(rectMax, glm::vec2(clip) / clip.w);
+	}
+	glm::vec2 size = glm::vec2(float(buffer.getWidth()), float(buffer.getHeight()));
+	glm::ivec2 pixelMin = glm::ivec2(glm::max((rectMin * 0.5f + 0.5f) * size - 0.5f, glm::vec2(0.0f)));
+	glm::ivec2 pixelMax = glm::ivec2(glm::min((rectMax * 0.5f + 0.5f) * size, size - 1.0f));
+	for (int y = pixelMin.y; y <= pixelMax.y; y++) {
+		for (int x = pixelMin.x; x <= pixelMax.x; x++) {
+			glm::vec2 ndc = (glm::vec2(float(x), float(y)) + 0.5f) / size * 2.0f - 1.0f;
+			glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+			glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+			glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+			glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+			float distance;
+			if (!BVH::intersectRay(min, max, origin, 1.0f / direction, 1.0f, distance)) continue;
+			glm::vec4 clip = viewProjection * glm::vec4(origin + distance * direction, 1.0f);
+			if (clip.z / clip.w * 0.5f + 0.5f < buffer.getDepth(x, y) - 1e-5f) return true;
+		}
+	}
+	return false;
+}
+
+/*!
+ * Rasterizes an asteroid field of sphere occluders on the CPU and tests 10k boxes behind it against the pyramid
+ * Checks that no box is hidden that the ray cast ground truth sees, and reports how many hidden boxes are found
+ */
+static void benchmarkOcclusionCulling()
+{
+	std::cout << "***** Occlusion culling, software rasterized *****\n\n";
+
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 viewProjection = projection * view;
+	GeometryData occluder = Geometry::createSphereGeometry(16, 8, 1.0f);
+
+	uint32_t random = 4711;
+	auto next = [&random]() {
+		random = random * 1664525u + 1013904223u;
+		return float(random >> 8) / float(1 << 24);
+	};
+	// asteroids between 15 and 40 units ahead, boxes scattered up to 150 units deep in the same cone
+	std::vector<glm::vec4> spheres;
+	for (int i = 0; i < 40; i++) {
+		float z = -15.0f - 25.0f * next();
+		spheres.push_back(glm::vec4((next() * 2.0f - 1.0f) * -z * 0.9f, (next() * 2.0f - 1.0f) * -z * 0.5f, z, 2.0f + 4.0f * next()));
+	}
+	// a few asteroids through the near plane, their triangles are clipped
+	for (int i = 0; i < 4; i++) spheres.push_back(glm::vec4((next() * 2.0f - 1.0f) * 6.0f, (next() * 2.0f - 1.0f) * 3.0f, -1.0f, 1.5f));
+	std::vector<glm::mat4> asteroids;
+	for (const glm::vec4& sphere : spheres) asteroids.push_back(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(sphere)), glm::vec3(sphere.w)));
+	const size_t boxCount = 10000;
+	std::vector<glm::vec3> boxMin(boxCount), boxMax(boxCount);
+	for (size_t i = 0; i < boxCount; i++) {
+		float z = -20.0f - 130.0f * next();
+		glm::vec3 center = glm::vec3((next() * 2.0f - 1.0f) * -z * 0.55f, (next() * 2.0f - 1.0f) * -z * 0.55f, z);
+		glm::vec3 halfSize = glm::vec3(0.25f + next(), 0.25f + next(), 0.25f + next());
+		boxMin[i] = center - halfSize;
+		boxMax[i] = center + halfSize;
+	}
+
+	OcclusionBuffer buffer(256, 128);
+	const int frames = 20;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		buffer.clear(viewProjection);
+		for (const glm::mat4& asteroid : asteroids) buffer.rasterize(occluder.positions, occluder.indices, asteroid);
+	}
+	double rasterizeSeconds = secondsSince(start) / frames;
+	start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) buffer.buildHiZ();
+	double pyramidSeconds = secondsSince(start) / frames;
+
+	std::vector<unsigned char> visible(boxCount);
+	size_t checksum = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		for (size_t i = 0; i < boxCount; i++) {
+			visible[i] = buffer.isVisible(boxMin[i], boxMax[i]) ? 1 : 0;
+			checksum += visible[i];
+		}
+	}
+	double testSeconds = secondsSince(start) / frames;
+
+	size_t hidden = 0, trulyHidden = 0, wronglyHidden = 0;
+	for (size_t i = 0; i < boxCount; i++) {
+		bool truth = isBoxVisibleAtPixels(buffer, viewProjection, boxMin[i], boxMax[i]);
+		if (!truth) trulyHidden++;
+		if (!visible[i]) hidden++;
+		if (!visible[i] && truth) wronglyHidden++;
+	}
+	bool passed = wronglyHidden == 0;
+
+	// the occluders have their vertices on the spheres, so they must never be in front of them
+	size_t pixelsInFront = 0;
+	glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+	for (unsigned int y = 0; y < buffer.getHeight(); y++) {
+		for (unsigned int x = 0; x < buffer.getWidth(); x++) {
+			glm::vec2 ndc = glm::vec2((float(x) + 0.5f) / float(buffer.getWidth()), (float(y) + 0.5f) / float(buffer.getHeight())) * 2.0f - 1.0f;
+			glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+			glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+			glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+			glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+			float nearest = 1.0f;
+			for (const glm::vec4& sphere : spheres) {
+				glm::vec3 offset = origin - glm::vec3(sphere);
+				float a = glm::dot(direction, direction), b = glm::dot(offset, direction), c = glm::dot(offset, offset) - sphere.w * sphere.w;
+				float discriminant = b * b - a * c;
+				if (discriminant < 0.0f || (-b + std::sqrt(discriminant)) / a < 0.0f) continue;
+				nearest = std::min(nearest, std::max((-b - std::sqrt(discriminant)) / a, 0.0f));
+			}
+			glm::vec4 clip = viewProjection * glm::vec4(origin + nearest * direction, 1.0f);
+			if (buffer.getDepth(x, y) < clip.z / clip.w * 0.5f + 0.5f - 1e-5f) pixelsInFront++;
+		}
+	}
+	passed = passed && pixelsInFront == 0;
+
+	std::cout << asteroids.size() << " occluders (" << asteroids.size() * occluder.indices.size() / 3 << " triangles) into "
+		<< buffer.getWidth() << "x" << buffer.getHeight() << ": " << rasterizeSeconds * 1000.0 << " ms, pyramid of "
+		<< buffer.getLevelCount() << " levels " << pyramidSeconds * 1000.0 << " ms\n";
+	std::cout << boxCount << " boxes: " << testSeconds * 1000.0 << " ms (" << testSeconds * 1e9 / boxCount << " ns/box), "
+		<< hidden << " hidden of " << trulyHidden << " hidden at every pixel [" << checksum << "]\n";
+	std::cout << wronglyHidden << " visible boxes reported hidden, " << pixelsInFront << " pixels in front of the asteroids " << (passed ? "PASSED" : "FAILED") << "\n";
+
+	// a box behind the nearest asteroid, one in front of it, one through the near plane and one behind the camera
+	buffer.clear(viewProjection);
+	buffer.rasterize(occluder.positions, occluder.indices, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f)), glm::vec3(4.0f)));
+	buffer.buildHiZ();
+	struct Case { const char* name; glm::vec3 min, max; bool visible; };
+	const Case cases[] = {
+		{ "behind the occluder", glm::vec3(-1.0f, -1.0f, -31.0f), glm::vec3(1.0f, 1.0f, -29.0f), false },
+		{ "in front of the occluder", glm::vec3(-1.0f, -1.0f, -5.0f), glm::vec3(1.0f, 1.0f, -4.0f), true },
+		{ "next to the occluder", glm::vec3(10.0f, -1.0f, -31.0f), glm::vec3(12.0f, 1.0f, -29.0f), true },
+		{ "larger than the occluder", glm::vec3(-20.0f, -20.0f, -31.0f), glm::vec3(20.0f, 20.0f, -29.0f), true },
+		{ "through the near plane", glm::vec3(-1.0f, -1.0f, -20.0f), glm::vec3(1.0f, 1.0f, 1.0f), true },
+		{ "behind the camera", glm::vec3(-1.0f, -1.0f, 5.0f), glm::vec3(1.0f, 1.0f, 6.0f), true }
+	};
+	bool casesPassed = true;
+	for (const Case& c : cases) {
+		if (buffer.isVisible(c.min, c.max) != c.visible) {
+			std::cout << c.name << ": expected " << (c.visible ? "visible" : "hidden") << "\n";
+			casesPassed = false;
+		}
+	}
+	std::cout << "boxes behind, beside and in front of an occluder " << (casesPassed ? "PASSED" : "FAILED") << "\n\n";
+}
+
+void runBenchmarks()
+{
+	benchmarkOBJLoader();
+	benchmarkVertexDeduplication();
+	benchmarkMeshOptimizer();
+	benchmarkMeshCache();
+	benchmarkVertexQuantization();
+	benchmarkNormalMatrices();
+	benchmarkDDSFiles();
+	benchmarkUniformLookups();
+	benchmarkRenderQueue();
+	benchmarkFrustumCulling();
+	benchmarkBVH();
+	benchmarkMeshSimplifier();
+	benchmarkOcclusionCulling();
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+/*!
+ * Runs all CPU-side benchmarks and prints the results to the console
+ * Started instead of the game with the command line argument "--benchmark"
+ */
+void runBenchmarks();
@@ -1,4 +1,5 @@
 #include "Camera.h";
+#include <cfloat>
 
 void Camera::positionUpdate(glm::vec3 newPosition) {
 	_position += newPosition;
@@ -6,6 +7,19 @@ void Camera::positionUpdate(glm::vec3 newPosition) {
 
 }
 
+Frustum Camera::getFrustum() {
+	return Frustum::fromMatrix(getViewProjectionMatrix());
+}
+
+float Camera::getScreenSize(const glm::vec3& center, float radius) {
+	float distance = glm::length(center - _position);
+	if (distance <= radius) return FLT_MAX;
+	// half the height of the view at distance 1, or half the width if the screen is taller than wide,
+	// taken from the projection so that the zoom is included
+	float halfView = 1.0f / glm::max(_projMatrix[0][0], _projMatrix[1][1]);
+	return radius / (distance * halfView);
+}
+
 void Camera::myPositionUpdate(glm::vec3 newPosition) {
 	_position = newPosition;
 	_viewMatrix = glm::lookAt(_position, _front + _position, glm::vec3(0.0, 1.0, 0.0));
@@ -12,6 +12,7 @@
 #include <glm\gtc\matrix_transform.hpp>
 #include <glm\gtx\euler_angles.hpp>
 #include "glm/ext.hpp"
+#include "Culling.h"
 
 /*!
  * Arc ball camera, modified by mouse input
@@ -60,6 +61,19 @@ public:
 	 */
 	glm::mat4 getViewProjectionMatrix();
 
+	/*!
+	 * @return the view frustum in world space, extracted from the view-projection matrix
+	 */
+	Frustum getFrustum();
+
+	/*!
+	 * Projects a bounding sphere with the projection matrix of the camera, including the zoom
+	 * @param center: center of the sphere in world space
+	 * @param radius: radius of the sphere
+	 * @return the diameter on screen relative to the smaller screen side, 1 fills it, very large if the camera is inside
+	 */
+	float getScreenSize(const glm::vec3& center, float radius);
+
 	/*!
 	 * Updates the camera's position and view matrix according to the input
 	 * @param x: current mouse x position
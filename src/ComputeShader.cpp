@@ -0,0 +1,93 @@
+#include "ComputeShader.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <glm\gtc\type_ptr.hpp>
+#include "GLState.h"
+#include "Utils.h"
+
+/* --------------------------------------------- */
+// Compute shader
+/* --------------------------------------------- */
+
+ComputeShader::ComputeShader(std::string file)
+	: _handle(0), _file(file)
+{
+	std::string path = "assets/shader/" + file;
+	MappedFile source(path.c_str());
+	if (!source.isOpen()) {
+		std::cout << "ERROR: Could not open compute shader " << path << std::endl;
+		return;
+	}
+
+	GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+	const GLchar* text = source.data();
+	GLint length = GLint(source.size());
+	glShaderSource(shader, 1, &text, &length);
+	glCompileShader(shader);
+	GLint status;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status == GL_FALSE) {
+		GLint logLength;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<GLchar> log(std::max(logLength, 1));
+		glGetShaderInfoLog(shader, GLsizei(log.size()), nullptr, log.data());
+		std::cout << "ERROR: Could not compile " << path << ":\n" << log.data() << std::endl;
+		glDeleteShader(shader);
+		return;
+	}
+
+	_handle = glCreateProgram();
+	glAttachShader(_handle, shader);
+	glLinkProgram(_handle);
+	glDetachShader(_handle, shader);
+	glDeleteShader(shader);
+	glGetProgramiv(_handle, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE) {
+		GLint logLength;
+		glGetProgramiv(_handle, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<GLchar> log(std::max(logLength, 1));
+		glGetProgramInfoLog(_handle, GLsizei(log.size()), nullptr, log.data());
+		std::cout << "ERROR: Could not link " << path << ":\n" << log.data() << std::endl;
+		UniformId::forget(_handle);
+		glDeleteProgram(_handle);
+		_handle = 0;
+	}
+}
+
+ComputeShader::~ComputeShader()
+{
+	if (_handle == 0) return;
+	UniformId::forget(_handle);
+	glDeleteProgram(_handle);
+}
+
+void ComputeShader::use() const
+{
+	GLState::useProgram(_handle);
+}
+
+void ComputeShader::dispatch(GLuint groupsX, GLuint groupsY, GLuint groupsZ) const
+{
+	glDispatchCompute(groupsX, groupsY, groupsZ);
+}
+
+void ComputeShader::setUniform(GLint location, const int value)
+{
+	glProgramUniform1i(_handle, location, value);
+}
+
+void ComputeShader::setUniform(GLint location, const unsigned int value)
+{
+	glProgramUniform1ui(_handle, location, value);
+}
+
+void ComputeShader::setUniform(GLint location, const float value)
+{
+	glProgramUniform1f(_handle, location, value);
+}
+
+void ComputeShader::setUniform(GLint location, const glm::mat4& value)
+{
+	glProgramUniformMatrix4fv(_handle, location, 1, GL_FALSE, glm::value_ptr(value));
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include "UniformId.h"
+
+/*!
+ * Compute shader program, the Shader class only links vertex and fragment shaders
+ */
+class ComputeShader
+{
+protected:
+	/*!
+	 * The shader program handle, 0 if the shader could not be compiled or linked
+	 */
+	GLuint _handle;
+
+	/*!
+	 * Path to the compute shader
+	 */
+	std::string _file;
+
+public:
+	/*!
+	 * Loads, compiles and links the compute shader, errors are printed
+	 * @param file: path to the compute shader, relative to assets/shader
+	 */
+	ComputeShader(std::string file);
+	~ComputeShader();
+
+	ComputeShader(const ComputeShader&) = delete;
+	ComputeShader& operator=(const ComputeShader&) = delete;
+
+	GLuint getHandle() const { return _handle; }
+	/*!
+	 * @return if the program was linked
+	 */
+	bool isValid() const { return _handle != 0; }
+
+	/*!
+	 * Uses the shader through GLState
+	 */
+	void use() const;
+	/*!
+	 * Runs the shader, it has to be in use
+	 * @param groupsX, groupsY, groupsZ: number of work groups in every dimension
+	 */
+	void dispatch(GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1) const;
+
+	/*!
+	 * Sets a uniform in the shader, it does not have to be in use
+	 * @param location: location ID of the uniform
+	 * @param value: the value to be set
+	 */
+	void setUniform(GLint location, const int value);
+	void setUniform(GLint location, const unsigned int value);
+	void setUniform(GLint location, const float value);
+	void setUniform(GLint location, const glm::mat4& value);
+	/*!
+	 * Sets a uniform in the shader through its interned id
+	 * @param uniform: the interned uniform, e.g. a static constant of the caller
+	 * @param value: the value to be set, any type of the location overloads
+	 */
+	template<typename T>
+	void setUniform(const UniformId& uniform, const T& value) { setUniform(uniform.getLocation(_handle), value); }
+};
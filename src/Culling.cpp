@@ -0,0 +1,103 @@
+#include "Culling.h"
+
+/* --------------------------------------------- */
+// Frustum
+/* --------------------------------------------- */
+
+Frustum Frustum::fromMatrix(const glm::mat4& viewProjection)
+{
+	// rows of the matrix, glm stores columns
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++) rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	Frustum frustum;
+	frustum.planes[LEFT] = rows[3] + rows[0];
+	frustum.planes[RIGHT] = rows[3] - rows[0];
+	frustum.planes[BOTTOM] = rows[3] + rows[1];
+	frustum.planes[TOP] = rows[3] - rows[1];
+	frustum.planes[NEAR_PLANE] = rows[3] + rows[2];
+	frustum.planes[FAR_PLANE] = rows[3] - rows[2];
+	for (glm::vec4& plane : frustum.planes) plane /= glm::length(glm::vec3(plane));
+	return frustum;
+}
+
+bool Frustum::containsSphere(const glm::vec3& center, float radius) const
+{
+	for (const glm::vec4& plane : planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+	}
+	return true;
+}
+
+Frustum::Containment Frustum::containsBox(const glm::vec3& min, const glm::vec3& max) const
+{
+	Containment result = INSIDE;
+	for (const glm::vec4& plane : planes) {
+		// the corners furthest along and against the normal
+		glm::vec3 positive = glm::vec3(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+		glm::vec3 negative = glm::vec3(plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y, plane.z >= 0.0f ? min.z : max.z);
+		if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f) return OUTSIDE;
+		if (glm::dot(glm::vec3(plane), negative) + plane.w < 0.0f) result = INTERSECTING;
+	}
+	return result;
+}
+
+/* --------------------------------------------- */
+// Sphere culler
+/* --------------------------------------------- */
+
+void SphereCuller::clear()
+{
+	_x.clear();
+	_y.clear();
+	_z.clear();
+	_radius.clear();
+}
+
+void SphereCuller::reserve(size_t count)
+{
+	_x.reserve(count);
+	_y.reserve(count);
+	_z.reserve(count);
+	_radius.reserve(count);
+}
+
+size_t SphereCuller::add(const glm::vec4& sphere)
+{
+	_x.push_back(sphere.x);
+	_y.push_back(sphere.y);
+	_z.push_back(sphere.z);
+	_radius.push_back(sphere.w);
+	return _x.size() - 1;
+}
+
+size_t SphereCuller::cull(const Frustum& frustum, std::vector<unsigned char>& visible) const
+{
+	const size_t count = _x.size();
+	visible.resize(count);
+
+	// copy the planes to locals, so the compiler knows they do not alias the output
+	const glm::vec4 p0 = frustum.planes[0], p1 = frustum.planes[1], p2 = frustum.planes[2];
+	const glm::vec4 p3 = frustum.planes[3], p4 = frustum.planes[4], p5 = frustum.planes[5];
+	const float* x = _x.data();
+	const float* y = _y.data();
+	const float* z = _z.data();
+	const float* radius = _radius.data();
+	unsigned char* result = visible.data();
+
+	// no early out, the same work for every sphere keeps the loop branch free
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < count; i++) {
+		const float r = -radius[i];
+		const int inside =
+			int(p0.x * x[i] + p0.y * y[i] + p0.z * z[i] + p0.w >= r) &
+			int(p1.x * x[i] + p1.y * y[i] + p1.z * z[i] + p1.w >= r) &
+			int(p2.x * x[i] + p2.y * y[i] + p2.z * z[i] + p2.w >= r) &
+			int(p3.x * x[i] + p3.y * y[i] + p3.z * z[i] + p3.w >= r) &
+			int(p4.x * x[i] + p4.y * y[i] + p4.z * z[i] + p4.w >= r) &
+			int(p5.x * x[i] + p5.y * y[i] + p5.z * z[i] + p5.w >= r);
+		result[i] = (unsigned char)inside;
+		visibleCount += inside;
+	}
+	return visibleCount;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+
+/*!
+ * The six planes of a view frustum
+ * Every plane is stored as (normal, distance) with a unit normal pointing into the frustum,
+ * so dot(normal, p) + distance is the signed distance of a point p to the plane.
+ */
+struct Frustum {
+	enum Plane { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANES };
+	/*!
+	 * Result of a box test
+	 */
+	enum Containment { OUTSIDE, INTERSECTING, INSIDE };
+	glm::vec4 planes[PLANES];
+
+	/*!
+	 * Extracts the planes from a view-projection matrix (OpenGL clip space, z in [-w, w])
+	 * @param viewProjection: the view-projection matrix, the planes are in world space
+	 * @return the frustum
+	 */
+	static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+	/*!
+	 * @param center: center of the sphere
+	 * @param radius: radius of the sphere
+	 * @return if the sphere is at least partly inside the frustum
+	 */
+	bool containsSphere(const glm::vec3& center, float radius) const;
+	/*!
+	 * Tests an axis aligned box, conservatively: boxes near a corner of the frustum may be reported as intersecting
+	 * @param min: minimum corner of the box
+	 * @param max: maximum corner of the box
+	 * @return if the box is outside, intersects a plane or is completely inside
+	 */
+	Containment containsBox(const glm::vec3& min, const glm::vec3& max) const;
+};
+
+/*!
+ * Tests many bounding spheres against a frustum at once
+ * The spheres are stored as one array per component, so the test runs over contiguous floats
+ * without branches and the compiler can vectorize it. Used for objects that move every frame,
+ * static objects are culled through their BVH.
+ */
+class SphereCuller
+{
+protected:
+	std::vector<float> _x, _y, _z, _radius;
+
+public:
+	/*!
+	 * Removes all spheres, the memory is kept for the next frame
+	 */
+	void clear();
+	void reserve(size_t count);
+
+	/*!
+	 * Adds a sphere
+	 * @param sphere: center (xyz) and radius (w)
+	 * @return the index of the sphere in the result of cull()
+	 */
+	size_t add(const glm::vec4& sphere);
+
+	/*!
+	 * @return the number of spheres
+	 */
+	size_t size() const { return _x.size(); }
+
+	/*!
+	 * Tests all spheres against the frustum
+	 * @param frustum: the frustum
+	 * @param visible: receives 1 for every sphere that is at least partly inside, 0 otherwise
+	 * @return the number of visible spheres
+	 */
+	size_t cull(const Frustum& frustum, std::vector<unsigned char>& visible) const;
+};
@@ -0,0 +1,207 @@
+#include "DDSFile.h"
+#include <cstring>
+#include <algorithm>
+
+/* --------------------------------------------- */
+// File format
+/* --------------------------------------------- */
+
+/*!
+ * DDS_PIXELFORMAT
+ */
+struct DDSPixelFormat {
+	unsigned int size;
+	unsigned int flags;
+	char fourCC[4];
+	unsigned int rgbBitCount;
+	unsigned int rBitMask, gBitMask, bBitMask, aBitMask;
+};
+
+/*!
+ * DDS_HEADER, follows the magic "DDS "
+ */
+struct DDSHeader {
+	unsigned int size;
+	unsigned int flags;
+	unsigned int height;
+	unsigned int width;
+	unsigned int pitchOrLinearSize;
+	unsigned int depth;
+	unsigned int mipMapCount;
+	unsigned int reserved1[11];
+	DDSPixelFormat pixelFormat;
+	unsigned int caps;
+	unsigned int caps2;
+	unsigned int caps3;
+	unsigned int caps4;
+	unsigned int reserved2;
+};
+
+/*!
+ * DDS_HEADER_DXT10, follows the header if the four CC is "DX10"
+ */
+struct DDSHeaderDX10 {
+	unsigned int dxgiFormat;
+	unsigned int resourceDimension;
+	unsigned int miscFlag;
+	unsigned int arraySize;
+	unsigned int miscFlags2;
+};
+
+static const unsigned int DDPF_FOURCC = 0x4;
+static const unsigned int DDSD_MIPMAPCOUNT = 0x20000;
+static const unsigned int DDSCAPS2_CUBEMAP = 0x200;
+static const unsigned int DDSCAPS2_CUBEMAP_ALLFACES = 0xFC00;
+static const unsigned int DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+static const unsigned int DDS_DIMENSION_TEXTURE2D = 3;
+
+/*!
+ * @return the OpenGL format and block size of a four CC code (GL_NONE if unsupported)
+ */
+static GLenum formatFromFourCC(const char fourCC[4], unsigned int& blockSize)
+{
+	struct { const char* fourCC; GLenum format; unsigned int blockSize; } formats[] = {
+		{ "DXT1", GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 8 },
+		{ "DXT3", GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 16 },
+		{ "DXT5", GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 16 },
+		{ "ATI1", GL_COMPRESSED_RED_RGTC1, 8 },
+		{ "BC4U", GL_COMPRESSED_RED_RGTC1, 8 },
+		{ "BC4S", GL_COMPRESSED_SIGNED_RED_RGTC1, 8 },
+		{ "ATI2", GL_COMPRESSED_RG_RGTC2, 16 },
+		{ "BC5U", GL_COMPRESSED_RG_RGTC2, 16 },
+		{ "BC5S", GL_COMPRESSED_SIGNED_RG_RGTC2, 16 },
+	};
+	for (const auto& f : formats) {
+		if (memcmp(fourCC, f.fourCC, 4) == 0) {
+			blockSize = f.blockSize;
+			return f.format;
+		}
+	}
+	return GL_NONE;
+}
+
+/*!
+ * @return the OpenGL format and block size of a DXGI format (GL_NONE if unsupported)
+ */
+static GLenum formatFromDXGI(unsigned int dxgiFormat, unsigned int& blockSize)
+{
+	blockSize = 16;
+	switch (dxgiFormat) {
+	case 71: blockSize = 8; return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;           // BC1_UNORM
+	case 72: blockSize = 8; return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;     // BC1_UNORM_SRGB
+	case 74: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;                          // BC2_UNORM
+	case 75: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;                    // BC2_UNORM_SRGB
+	case 77: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;                          // BC3_UNORM
+	case 78: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;                    // BC3_UNORM_SRGB
+	case 80: blockSize = 8; return GL_COMPRESSED_RED_RGTC1;                    // BC4_UNORM
+	case 81: blockSize = 8; return GL_COMPRESSED_SIGNED_RED_RGTC1;             // BC4_SNORM
+	case 83: return GL_COMPRESSED_RG_RGTC2;                                    // BC5_UNORM
+	case 84: return GL_COMPRESSED_SIGNED_RG_RGTC2;                             // BC5_SNORM
+	case 95: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;                     // BC6H_UF16
+	case 96: return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;                       // BC6H_SF16
+	case 98: return GL_COMPRESSED_RGBA_BPTC_UNORM;                             // BC7_UNORM
+	case 99: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;                       // BC7_UNORM_SRGB
+	default: return GL_NONE;
+	}
+}
+
+/* --------------------------------------------- */
+// DDS file
+/* --------------------------------------------- */
+
+DDSFile::DDSFile(const std::string& path)
+	: _file(path.c_str()), _valid(false), _format(GL_NONE), _width(0), _height(0), _mipLevels(0), _faces(0), _blockSize(0), _headerSize(0)
+{
+	_valid = parse(path.c_str());
+	if (!_valid) _levels.clear();
+}
+
+bool DDSFile::parse(const char* path)
+{
+	if (!_file.isOpen()) {
+		std::cout << "ERROR: Could not open DDS file " << path << std::endl;
+		return false;
+	}
+	if (_file.size() < 4 + sizeof(DDSHeader) || memcmp(_file.data(), "DDS ", 4) != 0) {
+		std::cout << "ERROR: " << path << " is not a DDS file" << std::endl;
+		return false;
+	}
+
+	DDSHeader header;
+	memcpy(&header, _file.data() + 4, sizeof(header));
+	if (header.size != sizeof(DDSHeader) || header.pixelFormat.size != sizeof(DDSPixelFormat)) {
+		std::cout << "ERROR: Invalid DDS header in " << path << std::endl;
+		return false;
+	}
+	if (!(header.pixelFormat.flags & DDPF_FOURCC)) {
+		std::cout << "ERROR: Uncompressed DDS files are not supported (" << path << ")" << std::endl;
+		return false;
+	}
+
+	_headerSize = 4 + sizeof(DDSHeader);
+	_faces = 1;
+	if (memcmp(header.pixelFormat.fourCC, "DX10", 4) == 0) {
+		if (_file.size() < _headerSize + sizeof(DDSHeaderDX10)) {
+			std::cout << "ERROR: Truncated DX10 header in " << path << std::endl;
+			return false;
+		}
+		DDSHeaderDX10 header10;
+		memcpy(&header10, _file.data() + _headerSize, sizeof(header10));
+		_headerSize += sizeof(DDSHeaderDX10);
+
+		if (header10.resourceDimension != DDS_DIMENSION_TEXTURE2D || header10.arraySize != 1) {
+			std::cout << "ERROR: Only 2D textures and cubemaps are supported (" << path << ")" << std::endl;
+			return false;
+		}
+		if (header10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) _faces = 6;
+		_format = formatFromDXGI(header10.dxgiFormat, _blockSize);
+	}
+	else {
+		if (header.caps2 & DDSCAPS2_CUBEMAP) {
+			if ((header.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES) {
+				std::cout << "ERROR: Cubemaps without all six faces are not supported (" << path << ")" << std::endl;
+				return false;
+			}
+			_faces = 6;
+		}
+		_format = formatFromFourCC(header.pixelFormat.fourCC, _blockSize);
+	}
+	if (_format == GL_NONE) {
+		std::cout << "ERROR: Unsupported DDS format in " << path << std::endl;
+		return false;
+	}
+
+	_width = header.width;
+	_height = header.height;
+	if (_width == 0 || _height == 0) {
+		std::cout << "ERROR: Invalid DDS size in " << path << std::endl;
+		return false;
+	}
+
+	unsigned int fullChain = 1;
+	while ((std::max(_width, _height) >> fullChain) > 0) fullChain++;
+	_mipLevels = (header.flags & DDSD_MIPMAPCOUNT) && header.mipMapCount > 0 ? header.mipMapCount : 1;
+	if (_mipLevels > fullChain) {
+		std::cout << "ERROR: Too many mip levels in " << path << std::endl;
+		return false;
+	}
+
+	// faces are stored one after the other, each with its full mip chain
+	_levels.resize(_faces * _mipLevels);
+	size_t offset = _headerSize;
+	for (unsigned int face = 0; face < _faces; face++) {
+		for (unsigned int level = 0; level < _mipLevels; level++) {
+			DDSLevel& l = _levels[face * _mipLevels + level];
+			l.width = std::max(_width >> level, 1u);
+			l.height = std::max(_height >> level, 1u);
+			l.offset = offset;
+			l.size = size_t((l.width + 3) / 4) * ((l.height + 3) / 4) * _blockSize;
+			offset += l.size;
+		}
+	}
+	if (offset > _file.size()) {
+		std::cout << "ERROR: Truncated DDS file " << path << std::endl;
+		return false;
+	}
+	return true;
+}
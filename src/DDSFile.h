@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <GL\glew.h>
+#include "Utils.h"
+
+/*!
+ * One mip level of one face in a DDS file
+ */
+struct DDSLevel {
+	unsigned int width;
+	unsigned int height;
+	/*!
+	 * Offset of the compressed data from the start of the file in bytes
+	 */
+	size_t offset;
+	/*!
+	 * Size of the compressed data in bytes
+	 */
+	size_t size;
+};
+
+/*!
+ * A block compressed DDS texture, mapped into memory
+ * Supports the legacy header (DXT1/3/5, ATI1/2, BC4/5) and the DX10 header (BC1-7, sRGB variants),
+ * 2D textures and cubemaps with all stored mip levels. The mip levels point into the mapped file,
+ * so they can be passed to glCompressedTexSubImage2D directly.
+ */
+class DDSFile
+{
+protected:
+	MappedFile _file;
+	bool _valid;
+
+	GLenum _format;
+	unsigned int _width;
+	unsigned int _height;
+	unsigned int _mipLevels;
+	unsigned int _faces;
+	unsigned int _blockSize;
+	size_t _headerSize;
+
+	/*!
+	 * All mip levels, face by face
+	 */
+	std::vector<DDSLevel> _levels;
+
+	/*!
+	 * Parses the headers and computes the mip levels
+	 * @return if the file is a complete DDS file in a supported format
+	 */
+	bool parse(const char* path);
+
+public:
+	/*!
+	 * Maps a DDS file and parses its headers
+	 * @param path: path to the DDS file
+	 */
+	DDSFile(const std::string& path);
+
+	/*!
+	 * @return if the file is a complete DDS file in a supported format
+	 */
+	bool isValid() const { return _valid; }
+	/*!
+	 * @return the compressed OpenGL internal format
+	 */
+	GLenum getFormat() const { return _format; }
+	unsigned int getWidth() const { return _width; }
+	unsigned int getHeight() const { return _height; }
+	/*!
+	 * @return the number of mip levels stored per face
+	 */
+	unsigned int getMipLevels() const { return _mipLevels; }
+	/*!
+	 * @return 6 for cubemaps, 1 otherwise
+	 */
+	unsigned int getFaces() const { return _faces; }
+	bool isCubemap() const { return _faces == 6; }
+	/*!
+	 * @return the size of one 4x4 block in bytes (8 or 16)
+	 */
+	unsigned int getBlockSize() const { return _blockSize; }
+	/*!
+	 * @return the size of the headers in bytes, i.e. the offset of the first mip level
+	 */
+	size_t getHeaderSize() const { return _headerSize; }
+	/*!
+	 * @return the size of the mapped file in bytes
+	 */
+	size_t getFileSize() const { return _file.size(); }
+
+	/*!
+	 * @param face: the cubemap face (0 for 2D textures), in the order +X, -X, +Y, -Y, +Z, -Z
+	 * @param level: the mip level
+	 * @return the size and position of the mip level
+	 */
+	const DDSLevel& getLevel(unsigned int face, unsigned int level) const { return _levels[face * _mipLevels + level]; }
+	/*!
+	 * @param face: the cubemap face (0 for 2D textures)
+	 * @param level: the mip level
+	 * @return the compressed data of the mip level
+	 */
+	const void* getLevelData(unsigned int face, unsigned int level) const { return _file.data() + getLevel(face, level).offset; }
+};
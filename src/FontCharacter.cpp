@@ -1,111 +1,490 @@
 #include "FontCharacter.h"
-void FontCharacter::initialize() {
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include "GLState.h"
+
+static const UniformId PROJECTION("projection");
+static const UniformId TEXT("text");
+static const UniformId OUTLINE_WIDTH("outlineWidth");
+static const UniformId OUTLINE_COLOR("outlineColor");
+static const UniformId SHADOW_OFFSET("shadowOffset");
+static const UniformId SHADOW_COLOR("shadowColor");
+
+const char* FontCharacter::FONT_FILE = "fonts/Helvetica.ttf";
+
+/* --------------------------------------------- */
+// Helpers
+/* --------------------------------------------- */
+
+static const char FONT_ATLAS_MAGIC[4] = { 'S', 'R', 'F', 'A' };
+
+/*!
+ * Squared distance transform of one row or column (Felzenszwalb and Huttenlocher)
+ * @param f: squared distances before, 0 at feature pixels and a large value elsewhere
+ * @param d: receives the squared distances
+ * @param v, z: scratch memory for n and n + 1 values
+ */
+static void distanceTransform1D(const float* f, float* d, int* v, float* z, int n)
+{
+	int k = 0;
+	v[0] = 0;
+	z[0] = -INFINITY;
+	z[1] = INFINITY;
+	for (int q = 1; q < n; q++) {
+		float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+		while (s <= z[k]) {
+			k--;
+			s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+		}
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = INFINITY;
+	}
+	k = 0;
+	for (int q = 0; q < n; q++) {
+		while (z[k + 1] < q) k++;
+		d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+	}
+}
+
+/*!
+ * Exact squared euclidean distance transform, the distance of every pixel to the nearest pixel with value 0
+ */
+static void distanceTransform(std::vector<float>& grid, int width, int height)
+{
+	int n = std::max(width, height);
+	std::vector<float> f(n), d(n), z(n + 1);
+	std::vector<int> v(n);
+	for (int x = 0; x < width; x++) {
+		for (int y = 0; y < height; y++) f[y] = grid[y * width + x];
+		distanceTransform1D(f.data(), d.data(), v.data(), z.data(), height);
+		for (int y = 0; y < height; y++) grid[y * width + x] = d[y];
+	}
+	for (int y = 0; y < height; y++) {
+		distanceTransform1D(&grid[y * width], d.data(), v.data(), z.data(), width);
+		std::copy(d.begin(), d.begin() + width, grid.begin() + y * width);
+	}
+}
+
+/*!
+ * Converts a coverage bitmap to a signed distance field with a border of spread pixels
+ * 0.5 is the outline, values above are inside, spread pixels map to 0.5.
+ */
+static std::vector<unsigned char> signedDistanceField(const unsigned char* coverage, int width, int height, int spread)
+{
+	int fieldWidth = width + 2 * spread;
+	int fieldHeight = height + 2 * spread;
+	// the distance to the nearest pixel on the other side, a large finite value so that the transform stays exact
+	const float far = float(fieldWidth * fieldWidth + fieldHeight * fieldHeight);
+	std::vector<float> toInside(fieldWidth * fieldHeight), toOutside(fieldWidth * fieldHeight);
+	for (int y = 0; y < fieldHeight; y++) {
+		for (int x = 0; x < fieldWidth; x++) {
+			int bx = x - spread, by = y - spread;
+			bool inside = bx >= 0 && by >= 0 && bx < width && by < height && coverage[by * width + bx] >= 128;
+			toInside[y * fieldWidth + x] = inside ? 0.0f : far;
+			toOutside[y * fieldWidth + x] = inside ? far : 0.0f;
+		}
+	}
+	distanceTransform(toInside, fieldWidth, fieldHeight);
+	distanceTransform(toOutside, fieldWidth, fieldHeight);
+
+	std::vector<unsigned char> field(fieldWidth * fieldHeight);
+	for (size_t i = 0; i < field.size(); i++) {
+		// the outline runs between pixel centers
+		float distance = toOutside[i] > 0.0f ? std::sqrt(toOutside[i]) - 0.5f : 0.5f - std::sqrt(toInside[i]);
+		float value = 0.5f + distance / (2.0f * spread);
+		field[i] = (unsigned char)(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+	return field;
+}
+
+static bool getFileSize(const char* path, unsigned long long& size)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes)) return false;
+	size = (unsigned long long)attributes.nFileSizeHigh << 32 | attributes.nFileSizeLow;
+	return true;
+}
+
+/* --------------------------------------------- */
+// Atlas
+/* --------------------------------------------- */
+
+FontCharacter::FontCharacter()
+	: Characters(), _VAO(0), _VBO(0), _atlas(0), _sdf(false), _glyphScale(1.0f),
+	_outlineWidth(0.0f), _outlineColor(0.0f), _shadowOffset(0.0f), _shadowColor(0.0f), _labelVertices(0), _capacity(0), _stats({ 0, 0, 0 })
+{
+}
+
+FontCharacter::~FontCharacter()
+{
+	if (_atlas != 0) GLState::deleteTextures(1, &_atlas);
+	if (_VBO != 0) GLState::deleteBuffers(1, &_VBO);
+	if (_VAO != 0) GLState::deleteVertexArrays(1, &_VAO);
+}
+
+bool FontCharacter::buildAtlas(std::vector<unsigned char>& pixels, int& height)
+{
 	FT_Library ft;
-	if (FT_Init_FreeType(&ft))
+	if (FT_Init_FreeType(&ft)) {
 		std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+		return false;
+	}
 
 	FT_Face face;
-	if (FT_New_Face(ft, "fonts/Helvetica.ttf", 0, &face))
+	if (FT_New_Face(ft, FONT_FILE, 0, &face)) {
 		std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-	FT_Set_Pixel_Sizes(face, 0, 0.000000005);
-	if (FT_Load_Char(face, 'X', FT_LOAD_RENDER))
-		std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Disable byte-alignment restriction
+		FT_Done_FreeType(ft);
+		return false;
+	}
+	FT_Set_Pixel_Sizes(face, 0, _sdf ? SDF_PIXEL_SIZE : PIXEL_SIZE);
+	int spread = _sdf ? int(SDF_SPREAD) : 0;
 
+	// Rasterize all glyphs and place them in rows of the atlas, 1 pixel apart so that filtering does not bleed
+	std::vector<std::vector<unsigned char>> bitmaps(128);
+	std::vector<glm::ivec2> offsets(128);
+	glm::ivec2 cursor(0);
+	int rowHeight = 0;
 	for (GLubyte c = 0; c < 128; c++)
 	{
-		// Load character glyph 
+		// Load character glyph
 		if (FT_Load_Char(face, c, FT_LOAD_RENDER))
 		{
 			std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
 			continue;
 		}
-		// Generate texture
-		GLuint texture;
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(
-			GL_TEXTURE_2D,
-			0,
-			GL_RED,
-			face->glyph->bitmap.width,
-			face->glyph->bitmap.rows,
-			0,
-			GL_RED,
-			GL_UNSIGNED_BYTE,
-			face->glyph->bitmap.buffer
-		);
-		// Set texture options
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
-		// Now store character for later use
-		FontCharacterData character = {
-			texture,
-			glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-			glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-			face->glyph->advance.x
-		};
-		Characters.insert(std::pair<GLchar, FontCharacterData>(c, character));
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-
-		glGenVertexArrays(1, &_VAO);
-		glGenBuffers(1, &_VBO);
-		glBindVertexArray(_VAO);
-		glBindBuffer(GL_ARRAY_BUFFER, _VBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+		const FT_Bitmap& bitmap = face->glyph->bitmap;
+		int width = int(bitmap.width);
+		int rows = int(bitmap.rows);
+
+		// Copy the bitmap, rows may be padded
+		bitmaps[c].resize(width * rows);
+		for (int row = 0; row < rows; row++) {
+			std::copy(bitmap.buffer + row * bitmap.pitch, bitmap.buffer + row * bitmap.pitch + width, bitmaps[c].begin() + row * width);
+		}
+
+		// Now store character for later use, the atlas coordinates follow once its height is known
+		FontCharacterData& character = Characters[c];
+		character.Size = glm::ivec2(width, rows);
+		character.Bearing = glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+		character.Advance = GLuint(face->glyph->advance.x);
+
+		// A distance field extends beyond the glyph, the quad grows with it
+		if (spread > 0 && width > 0 && rows > 0) {
+			bitmaps[c] = signedDistanceField(bitmaps[c].data(), width, rows, spread);
+			character.Size += glm::ivec2(2 * spread);
+			character.Bearing += glm::ivec2(-spread, spread);
+		}
+
+		if (cursor.x + character.Size.x > int(ATLAS_WIDTH)) {
+			cursor = glm::ivec2(0, cursor.y + rowHeight + 1);
+			rowHeight = 0;
+		}
+		offsets[c] = cursor;
+		cursor.x += character.Size.x + 1;
+		rowHeight = std::max(rowHeight, character.Size.y);
+	}
+	FT_Done_Face(face);
+	FT_Done_FreeType(ft);
+
+	// Assemble the atlas, the first row of a glyph is its top
+	height = std::max(cursor.y + rowHeight, 1);
+	pixels.assign(ATLAS_WIDTH * height, 0);
+	glm::vec2 atlasSize = glm::vec2(float(ATLAS_WIDTH), float(height));
+	for (unsigned int c = 0; c < 128; c++) {
+		FontCharacterData& character = Characters[c];
+		for (int row = 0; row < character.Size.y; row++) {
+			std::copy(bitmaps[c].begin() + row * character.Size.x, bitmaps[c].begin() + (row + 1) * character.Size.x,
+				pixels.begin() + (offsets[c].y + row) * ATLAS_WIDTH + offsets[c].x);
+		}
+		character.UVMin = glm::vec2(offsets[c]) / atlasSize;
+		character.UVMax = glm::vec2(offsets[c] + character.Size) / atlasSize;
 	}
+	return true;
 }
-void FontCharacter::RenderText(std::shared_ptr<Shader> &s, std::string text, GLfloat x, GLfloat y, GLfloat scale)
+
+bool FontCharacter::loadAtlas(const std::string& path, std::vector<unsigned char>& pixels, int& height)
 {
-	// Activate corresponding render state	
+	MappedFile file(path.c_str());
+	if (file.size() < sizeof(FontAtlasHeader)) return false;
+
+	const FontAtlasHeader* header = reinterpret_cast<const FontAtlasHeader*>(file.data());
+	if (memcmp(header->magic, FONT_ATLAS_MAGIC, sizeof(FONT_ATLAS_MAGIC)) != 0 || header->version != SDF_CACHE_VERSION) return false;
+	if (header->pixelSize != SDF_PIXEL_SIZE || header->spread != SDF_SPREAD || header->width != ATLAS_WIDTH) return false;
+	// the font never changes in place, its size tells a replaced font apart
+	unsigned long long sourceSize;
+	if (getFileSize(FONT_FILE, sourceSize) && sourceSize != header->sourceSize) return false;
+
+	size_t expectedSize = sizeof(FontAtlasHeader) + 128 * sizeof(FontAtlasGlyph) + size_t(header->width) * header->height;
+	if (file.size() != expectedSize) return false;
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(_VAO);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	const FontAtlasGlyph* glyphs = reinterpret_cast<const FontAtlasGlyph*>(file.data() + sizeof(FontAtlasHeader));
+	for (unsigned int c = 0; c < 128; c++) {
+		FontCharacterData& character = Characters[c];
+		character.UVMin = glm::vec2(glyphs[c].uvMin[0], glyphs[c].uvMin[1]);
+		character.UVMax = glm::vec2(glyphs[c].uvMax[0], glyphs[c].uvMax[1]);
+		character.Size = glm::ivec2(glyphs[c].size[0], glyphs[c].size[1]);
+		character.Bearing = glm::ivec2(glyphs[c].bearing[0], glyphs[c].bearing[1]);
+		character.Advance = glyphs[c].advance;
+	}
+	const unsigned char* atlas = reinterpret_cast<const unsigned char*>(glyphs + 128);
+	pixels.assign(atlas, atlas + size_t(header->width) * header->height);
+	height = int(header->height);
+	return true;
+}
+
+bool FontCharacter::saveAtlas(const std::string& path, const std::vector<unsigned char>& pixels, int height)
+{
+	FontAtlasHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, FONT_ATLAS_MAGIC, sizeof(FONT_ATLAS_MAGIC));
+	header.version = SDF_CACHE_VERSION;
+	if (!getFileSize(FONT_FILE, header.sourceSize)) return false;
+	header.pixelSize = SDF_PIXEL_SIZE;
+	header.spread = SDF_SPREAD;
+	header.width = ATLAS_WIDTH;
+	header.height = unsigned(height);
+
+	FontAtlasGlyph glyphs[128];
+	for (unsigned int c = 0; c < 128; c++) {
+		const FontCharacterData& character = Characters[c];
+		glyphs[c] = { { character.UVMin.x, character.UVMin.y }, { character.UVMax.x, character.UVMax.y },
+			{ character.Size.x, character.Size.y }, { character.Bearing.x, character.Bearing.y }, character.Advance };
+	}
+
+	// write to a temporary file first, so that a crash never leaves a broken cache behind
+	std::string tempPath = path + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (file == NULL) return false;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && fwrite(glyphs, sizeof(FontAtlasGlyph), 128, file) == 128;
+	ok = ok && fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+	ok = fclose(file) == 0 && ok;
+
+	if (!ok || !MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		DeleteFileA(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
 
-	// Iterate through all characters
-	std::string::const_iterator c;
-	for (c = text.begin(); c != text.end(); c++)
+void FontCharacter::initialize(bool sdf) {
+	_sdf = sdf;
+	_glyphScale = float(PIXEL_SIZE) / float(sdf ? SDF_PIXEL_SIZE : PIXEL_SIZE);
+
+	// FreeType only runs without a valid distance field cache
+	std::string cachePath = std::string(FONT_FILE) + ".sdf";
+	std::vector<unsigned char> pixels;
+	int atlasHeight = 0;
+	if (!sdf || !loadAtlas(cachePath, pixels, atlasHeight)) {
+		if (!buildAtlas(pixels, atlasHeight)) return;
+		if (sdf && !saveAtlas(cachePath, pixels, atlasHeight)) {
+			std::cout << "ERROR: Could not create font cache " << cachePath << std::endl;
+		}
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Disable byte-alignment restriction
+	glGenTextures(1, &_atlas);
+	GLState::bindTexture(GL_TEXTURE_2D, _atlas);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_WIDTH, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	// Set texture options
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// One streaming buffer for the quads of all text, position and uv form one vec4
+	glGenVertexArrays(1, &_VAO);
+	glGenBuffers(1, &_VBO);
+	GLState::bindVertexArray(_VAO);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, _VBO);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, color));
+	GLState::bindVertexArray(0);
+}
+
+/* --------------------------------------------- */
+// Text
+/* --------------------------------------------- */
+
+void FontCharacter::setScreenSize(int width, int height)
+{
+	projection = glm::ortho(0.0f, float(width), 0.0f, float(height));
+}
+
+void FontCharacter::setOutline(float width, const glm::vec4& color)
+{
+	_outlineWidth = width;
+	_outlineColor = color;
+}
+
+void FontCharacter::setShadow(const glm::vec2& offset, const glm::vec4& color)
+{
+	_shadowOffset = offset;
+	_shadowColor = color;
+}
+
+size_t FontCharacter::layout(const std::string& text, GLfloat x, GLfloat y, GLfloat scale, const glm::vec4& color, std::vector<TextVertex>& vertices, size_t maxGlyphs) const
+{
+	size_t glyphs = 0;
+	scale *= _glyphScale;
+	for (char c : text)
 	{
-		FontCharacterData ch = Characters[*c];
+		if ((unsigned char)c >= 128) continue;
+		const FontCharacterData& ch = Characters[(unsigned char)c];
 
 		GLfloat xpos = x + ch.Bearing.x * scale;
 		GLfloat ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
 
 		GLfloat w = ch.Size.x * scale;
 		GLfloat h = ch.Size.y * scale;
-		// Update VBO for each character
-		GLfloat vertices[6][4] = {
-			{ xpos,     ypos + h,   0.0, 0.0 },
-			{ xpos,     ypos,       0.0, 1.0 },
-			{ xpos + w, ypos,       1.0, 1.0 },
-
-			{ xpos,     ypos + h,   0.0, 0.0 },
-			{ xpos + w, ypos,       1.0, 1.0 },
-			{ xpos + w, ypos + h,   1.0, 0.0 }
-		};
-		// Render glyph texture over quad
-		glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-		// Update content of VBO memory
-		glBindBuffer(GL_ARRAY_BUFFER, _VBO);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		// Render quad
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		if (ch.Size.x > 0 && ch.Size.y > 0) {
+			if (glyphs == maxGlyphs) break;
+			glyphs++;
+			TextVertex topLeft = { glm::vec2(xpos, ypos + h), ch.UVMin, color };
+			TextVertex bottomLeft = { glm::vec2(xpos, ypos), glm::vec2(ch.UVMin.x, ch.UVMax.y), color };
+			TextVertex bottomRight = { glm::vec2(xpos + w, ypos), ch.UVMax, color };
+			TextVertex topRight = { glm::vec2(xpos + w, ypos + h), glm::vec2(ch.UVMax.x, ch.UVMin.y), color };
+			vertices.insert(vertices.end(), { topLeft, bottomLeft, bottomRight, topLeft, bottomRight, topRight });
+		}
 		// Now advance cursors for next glyph (note that advance is number of 1/64 pixels)
 		x += (ch.Advance >> 6) * scale; // Bitshift by 6 to get value in pixels (2^6 = 64)
 	}
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
-}
\ No newline at end of file
+	return glyphs;
+}
+
+void FontCharacter::addText(const std::string& text, GLfloat x, GLfloat y, GLfloat scale, const glm::vec4& color)
+{
+	layout(text, x, y, scale, color, _vertices);
+}
+
+TextLabel* FontCharacter::createLabel(size_t maxLength)
+{
+	_labels.push_back(std::unique_ptr<TextLabel>(new TextLabel(this, _labelVertices, maxLength)));
+	_labelVertices += 6 * maxLength;
+	return _labels.back().get();
+}
+
+void FontCharacter::flush(std::shared_ptr<Shader> &s)
+{
+	_stats.glyphs = _vertices.size() / 6;
+	_stats.drawCalls = 0;
+	_stats.uploadedBytes = 0;
+	if (_vertices.empty() && _labels.empty()) return;
+
+	// Only changed labels are uploaded, a larger buffer loses the labels, so they are all uploaded again
+	GLState::bindVertexArray(_VAO);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, _VBO);
+	size_t vertexCount = _labelVertices + _vertices.size();
+	bool reallocated = vertexCount > _capacity;
+	if (reallocated) {
+		_capacity = vertexCount;
+		glBufferData(GL_ARRAY_BUFFER, _capacity * sizeof(TextVertex), nullptr, GL_DYNAMIC_DRAW);
+	}
+	for (const std::unique_ptr<TextLabel>& label : _labels) {
+		bool changed = label->update();
+		_stats.glyphs += label->_glyphs;
+		if (!changed && !reallocated) continue;
+		size_t bytes = label->_vertices.size() * sizeof(TextVertex);
+		glBufferSubData(GL_ARRAY_BUFFER, label->_first * sizeof(TextVertex), bytes, label->_vertices.data());
+		_stats.uploadedBytes += bytes;
+	}
+	// the added text follows the labels
+	if (!_vertices.empty()) {
+		size_t bytes = _vertices.size() * sizeof(TextVertex);
+		glBufferSubData(GL_ARRAY_BUFFER, _labelVertices * sizeof(TextVertex), bytes, _vertices.data());
+		_stats.uploadedBytes += bytes;
+	}
+	if (_stats.glyphs == 0) {
+		GLState::bindVertexArray(0);
+		return;
+	}
+
+	// Activate corresponding render state, text is drawn over the scene
+	GLState::useProgram(s->getHandle());
+	s->setUniform(PROJECTION, projection);
+	s->setUniform(TEXT, 0);
+	if (_sdf) {
+		// outline width as a distance field value, shadow offset in atlas pixels, both limited by the spread
+		float outlineWidth = glm::clamp(_outlineWidth / _glyphScale, 0.0f, float(SDF_SPREAD)) / (2.0f * SDF_SPREAD);
+		s->setUniform(OUTLINE_WIDTH, outlineWidth);
+		s->setUniform(OUTLINE_COLOR, _outlineColor);
+		s->setUniform(SHADOW_OFFSET, glm::clamp(_shadowOffset / _glyphScale, glm::vec2(-float(SDF_SPREAD)), glm::vec2(float(SDF_SPREAD))));
+		s->setUniform(SHADOW_COLOR, _shadowColor);
+	}
+	GLState::bindTexture(0, GL_TEXTURE_2D, _atlas);
+	GLState::disable(GL_DEPTH_TEST);
+	GLState::enable(GL_BLEND);
+	GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertexCount));
+	_stats.drawCalls = 1;
+
+	GLState::disable(GL_BLEND);
+	GLState::enable(GL_DEPTH_TEST);
+	GLState::bindVertexArray(0);
+	_vertices.clear();
+}
+
+void FontCharacter::RenderText(std::shared_ptr<Shader> &s, std::string text, GLfloat x, GLfloat y, GLfloat scale)
+{
+	addText(text, x, y, scale);
+	flush(s);
+}
+
+/* --------------------------------------------- */
+// Label
+/* --------------------------------------------- */
+
+TextLabel::TextLabel(FontCharacter* font, size_t first, size_t maxLength)
+	: _font(font), _first(first), _maxLength(maxLength), _position(0.0f), _scale(1.0f), _color(1.0f),
+	_vertices(6 * maxLength), _glyphs(0), _dirty(true)
+{
+}
+
+bool TextLabel::update()
+{
+	if (!_dirty) return false;
+	_vertices.clear();
+	_glyphs = _font->layout(_text, _position.x, _position.y, _scale, _color, _vertices, _maxLength);
+	// degenerate quads fill the rest of the range, they are dropped before rasterization
+	_vertices.resize(6 * _maxLength, TextVertex{ glm::vec2(0.0f), glm::vec2(0.0f), glm::vec4(0.0f) });
+	_dirty = false;
+	return true;
+}
+
+void TextLabel::setText(const std::string& text)
+{
+	if (text == _text) return;
+	_text = text;
+	_dirty = true;
+}
+
+void TextLabel::setPosition(const glm::vec2& position)
+{
+	if (position == _position) return;
+	_position = position;
+	_dirty = true;
+}
+
+void TextLabel::setScale(float scale)
+{
+	if (scale == _scale) return;
+	_scale = scale;
+	_dirty = true;
+}
+
+void TextLabel::setColor(const glm::vec4& color)
+{
+	if (color == _color) return;
+	_color = color;
+	_dirty = true;
+}
@@ -1,24 +1,294 @@
 #pragma once
 #include <ft2build.h>
-#include FT_FREETYPE_H  
+#include FT_FREETYPE_H
+#include <cstdint>
+#include <memory>
+#include <vector>
 #include "Utils.h"
 #include "Shader.h"
 struct FontCharacterData {
 public:
-	GLuint     TextureID;  // ID handle of the glyph texture
+	glm::vec2  UVMin;      // Upper left corner of the glyph in the atlas
+	glm::vec2  UVMax;      // Lower right corner of the glyph in the atlas
 	glm::ivec2 Size;       // Size of glyph
 	glm::ivec2 Bearing;    // Offset from baseline to left/top of glyph
 	GLuint     Advance;    // Offset to advance to next glyph
 };
 
+/*!
+ * Header of a binary signed distance field font cache file
+ * The header is followed by one FontAtlasGlyph per ASCII character and the 8 bit atlas pixels, top row first.
+ */
+struct FontAtlasHeader {
+	/*!
+	 * File identification, always "SRFA"
+	 */
+	char magic[4];
+	/*!
+	 * Format version, files with another version are rebuilt
+	 */
+	unsigned int version;
+	/*!
+	 * Size of the font file in bytes
+	 */
+	unsigned long long sourceSize;
+	/*!
+	 * Pixel height the glyphs were rasterized at
+	 */
+	unsigned int pixelSize;
+	/*!
+	 * Distance in pixels that maps to the full value range
+	 */
+	unsigned int spread;
+	/*!
+	 * Size of the atlas in pixels
+	 */
+	unsigned int width;
+	unsigned int height;
+};
+
+/*!
+ * Glyph record of a font cache file
+ */
+struct FontAtlasGlyph {
+	float uvMin[2];
+	float uvMax[2];
+	int size[2];
+	int bearing[2];
+	unsigned int advance;
+};
+
+/*!
+ * One corner of a glyph quad in the text vertex buffer
+ */
+struct TextVertex {
+	glm::vec2 position;
+	glm::vec2 uv;
+	glm::vec4 color;
+};
+
+/*!
+ * Number of glyphs, draw calls and uploaded bytes of the last flush
+ */
+struct TextStats {
+	size_t glyphs;
+	size_t drawCalls;
+	size_t uploadedBytes;
+};
+
+class FontCharacter;
+
+/*!
+ * Text that stays on screen over many frames, e.g. a HUD readout
+ * The quads are kept in a fixed range of the text vertex buffer and only laid out and uploaded again
+ * when the text, position, scale or color change.
+ */
+class TextLabel {
+	friend class FontCharacter;
+protected:
+	FontCharacter* _font;
+	/*!
+	 * First vertex and number of glyphs of the range in the vertex buffer
+	 */
+	size_t _first;
+	size_t _maxLength;
+
+	std::string _text;
+	glm::vec2 _position;
+	float _scale;
+	glm::vec4 _color;
+
+	/*!
+	 * Quads of the whole range, unused glyphs are degenerate
+	 */
+	std::vector<TextVertex> _vertices;
+	size_t _glyphs;
+	/*!
+	 * If the quads have to be laid out and uploaded again
+	 */
+	bool _dirty;
+
+	TextLabel(FontCharacter* font, size_t first, size_t maxLength);
+
+	/*!
+	 * Lays out the quads if anything changed
+	 * @return if the quads changed and have to be uploaded
+	 */
+	bool update();
+
+public:
+	/*!
+	 * Sets the text, nothing is done if it did not change
+	 * @param text: the string, glyphs beyond the maximum length are cut off
+	 */
+	void setText(const std::string& text);
+	/*!
+	 * Sets the left of the baseline in pixels, from the bottom left of the screen
+	 */
+	void setPosition(const glm::vec2& position);
+	/*!
+	 * Sets the size of the text, 1 is 48 pixels high
+	 */
+	void setScale(float scale);
+	void setColor(const glm::vec4& color);
+
+	const std::string& getText() const { return _text; }
+};
 
+/*!
+ * Renders text from one glyph atlas
+ * Text is collected with addText() and drawn with one draw call per flush(), no matter how many strings and characters.
+ * Text that changes rarely should use a TextLabel, which is only uploaded again when it changes.
+ * The vertex buffer holds the ranges of all labels followed by the text added this frame.
+ * The atlas holds either coverage bitmaps (HUD.fragment) or signed distance fields (HUD_SDF.fragment).
+ * A distance field renders sharp at any size and supports outlines and shadows; it is cached next to the font file,
+ * so FreeType only runs when the cache is missing or outdated.
+ */
 class FontCharacter {
 protected:
-	std::map<GLchar, FontCharacterData> Characters;
+	/*!
+	 * Font file, the distance field cache is stored next to it
+	 */
+	static const char* FONT_FILE;
+	/*!
+	 * Pixel height of the bitmap glyphs, a text scale of 1 is this high
+	 */
+	static const unsigned int PIXEL_SIZE = 48;
+	/*!
+	 * Pixel height of the distance field glyphs, and the distance in pixels that maps to the full value range
+	 */
+	static const unsigned int SDF_PIXEL_SIZE = 32;
+	static const unsigned int SDF_SPREAD = 6;
+	/*!
+	 * Version of the cache file format, increment when changing the format or the distance field generation
+	 */
+	static const unsigned int SDF_CACHE_VERSION = 1;
+	/*!
+	 * Width of the glyph atlas, the height grows with the glyphs
+	 */
+	static const unsigned int ATLAS_WIDTH = 512;
+
+	FontCharacterData Characters[128];
 	glm::mat4 projection = glm::ortho(0.0f, 800.0f, 0.0f, 600.0f);
 	GLuint _VAO, _VBO;
+	GLuint _atlas;
+
+	/*!
+	 * If the atlas holds distance fields
+	 */
+	bool _sdf;
+	/*!
+	 * Pixels of a text with scale 1 per atlas pixel, the distance field glyphs are smaller than the bitmap glyphs
+	 */
+	float _glyphScale;
+	float _outlineWidth;
+	glm::vec4 _outlineColor;
+	glm::vec2 _shadowOffset;
+	glm::vec4 _shadowColor;
+
+	/*!
+	 * Quads of the text added since the last flush, uploaded at once
+	 */
+	std::vector<TextVertex> _vertices;
+	std::vector<std::unique_ptr<TextLabel>> _labels;
+	/*!
+	 * Number of vertices of all label ranges
+	 */
+	size_t _labelVertices;
+	size_t _capacity;
+	TextStats _stats;
+
+	/*!
+	 * Rasterizes the glyphs with FreeType and packs them into the atlas
+	 * @param pixels: receives the atlas pixels, top row first
+	 * @param height: receives the atlas height
+	 * @return if the font could be loaded
+	 */
+	bool buildAtlas(std::vector<unsigned char>& pixels, int& height);
+	/*!
+	 * Reads the glyphs and the atlas from the distance field cache
+	 * @return if the cache exists and matches the font and the current settings
+	 */
+	bool loadAtlas(const std::string& path, std::vector<unsigned char>& pixels, int& height);
+	/*!
+	 * Writes the glyphs and the atlas to the distance field cache
+	 * @return if the cache was written
+	 */
+	bool saveAtlas(const std::string& path, const std::vector<unsigned char>& pixels, int height);
+
+	/*!
+	 * Lays out the quads of a string
+	 * @param vertices: receives 6 vertices per glyph
+	 * @param maxGlyphs: glyphs beyond are cut off
+	 * @return the number of glyphs
+	 */
+	size_t layout(const std::string& text, GLfloat x, GLfloat y, GLfloat scale, const glm::vec4& color, std::vector<TextVertex>& vertices, size_t maxGlyphs = SIZE_MAX) const;
+
+	friend class TextLabel;
+
 public:
-	void initialize();
+	FontCharacter();
+	~FontCharacter();
+
+	FontCharacter(const FontCharacter&) = delete;
+	FontCharacter& operator=(const FontCharacter&) = delete;
+
+	/*!
+	 * Creates the glyph atlas and the vertex buffer
+	 * @param sdf: if the atlas holds signed distance fields, to be drawn with HUD_SDF.fragment
+	 */
+	void initialize(bool sdf = false);
+
+	/*!
+	 * Sets the size of the screen that text positions refer to
+	 * @param width: width in pixels
+	 * @param height: height in pixels
+	 */
+	void setScreenSize(int width, int height);
+
+	/*!
+	 * Sets the outline of distance field text
+	 * @param width: outline width in pixels of a text with scale 1, 0 disables the outline
+	 * @param color: outline color
+	 */
+	void setOutline(float width, const glm::vec4& color);
+	/*!
+	 * Sets the drop shadow of distance field text
+	 * @param offset: offset to the right and down in pixels of a text with scale 1, at most 9 pixels
+	 * @param color: shadow color, alpha 0 disables the shadow
+	 */
+	void setShadow(const glm::vec2& offset, const glm::vec4& color);
+
+	/*!
+	 * Adds a string to the next flush
+	 * @param text: the string, characters outside of ASCII are skipped
+	 * @param x: left of the baseline in pixels
+	 * @param y: height of the baseline in pixels, from the bottom of the screen
+	 * @param scale: size of the text, 1 is 48 pixels high
+	 * @param color: color of the text
+	 */
+	void addText(const std::string& text, GLfloat x, GLfloat y, GLfloat scale, const glm::vec4& color = glm::vec4(1.0f));
+
+	/*!
+	 * Creates a label that is drawn by every flush until the font is destroyed
+	 * @param maxLength: maximum number of characters
+	 * @return the label, owned by the font
+	 */
+	TextLabel* createLabel(size_t maxLength);
+
+	/*!
+	 * Uploads the changed labels and the added text, draws them with one draw call and clears the added text
+	 * @param s: the HUD shader, HUD_SDF.fragment for distance fields
+	 */
+	void flush(std::shared_ptr<Shader> &s);
+
+	/*!
+	 * Draws one string right away
+	 */
 	void RenderText(std::shared_ptr<Shader> &s, std::string text, GLfloat x, GLfloat y, GLfloat scale);
 
-};
\ No newline at end of file
+	/*!
+	 * @return the number of glyphs, draw calls and bytes uploaded by the last flush
+	 */
+	const TextStats& getStats() const { return _stats; }
+};
@@ -0,0 +1,52 @@
+#include "FrameUniforms.h"
+#include <cstddef>
+#include "GLState.h"
+
+static_assert(offsetof(FrameData, cameraWorld) == 64, "FrameData does not match the std140 layout");
+static_assert(offsetof(FrameData, dirLightCount) == 76, "FrameData does not match the std140 layout");
+static_assert(offsetof(FrameData, pointLightCount) == 80, "FrameData does not match the std140 layout");
+static_assert(offsetof(FrameData, dirLights) == 96, "FrameData does not match the std140 layout");
+static_assert(offsetof(FrameData, pointLights) == 96 + 32 * MAX_DIR_LIGHTS, "FrameData does not match the std140 layout");
+
+FrameUniforms::FrameUniforms()
+	: _buffer(0), _data()
+{
+	glGenBuffers(1, &_buffer);
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, _buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+	GLState::deleteBuffers(1, &_buffer);
+}
+
+void FrameUniforms::update(Camera& camera, const std::vector<DirectionalLight>& dirLights, const std::vector<PointLight>& pointLights)
+{
+	_data.viewProjMatrix = camera.getViewProjectionMatrix();
+	_data.cameraWorld = camera.getPosition();
+
+	_data.dirLightCount = 0;
+	for (const DirectionalLight& light : dirLights) {
+		if (!light.enabled || _data.dirLightCount == GLint(MAX_DIR_LIGHTS)) continue;
+		_data.dirLights[_data.dirLightCount].color = glm::vec4(light.color, 0.0f);
+		_data.dirLights[_data.dirLightCount].direction = glm::vec4(light.direction, 0.0f);
+		_data.dirLightCount++;
+	}
+	_data.pointLightCount = 0;
+	for (const PointLight& light : pointLights) {
+		if (!light.enabled || _data.pointLightCount == GLint(MAX_POINT_LIGHTS)) continue;
+		_data.pointLights[_data.pointLightCount].color = glm::vec4(light.color, 0.0f);
+		_data.pointLights[_data.pointLightCount].position = glm::vec4(light.position, 1.0f);
+		_data.pointLights[_data.pointLightCount].attenuation = glm::vec4(light.attenuation, 0.0f);
+		_data.pointLightCount++;
+	}
+
+	// orphan the buffer, the previous frame may still read it
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, _buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &_data);
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, 0);
+	GLState::bindBufferBase(GL_UNIFORM_BUFFER, BINDING, _buffer);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include "Camera.h"
+#include "Light.h"
+
+/*!
+ * Maximum number of lights in the per-frame uniform block, has to match MAX_DIR_LIGHTS and MAX_POINT_LIGHTS in the shaders
+ */
+const unsigned int MAX_DIR_LIGHTS = 4;
+const unsigned int MAX_POINT_LIGHTS = 8;
+
+/*!
+ * The per-frame uniform block FrameData in std140 layout
+ * vec3 members are padded to 16 bytes, the light counts fill the padding after camera_world.
+ */
+struct FrameData {
+	glm::mat4 viewProjMatrix;
+	glm::vec3 cameraWorld;
+	GLint dirLightCount;
+	GLint pointLightCount;
+	GLint padding[3];
+	struct {
+		glm::vec4 color;
+		glm::vec4 direction;
+	} dirLights[MAX_DIR_LIGHTS];
+	struct {
+		glm::vec4 color;
+		glm::vec4 position;
+		glm::vec4 attenuation;
+	} pointLights[MAX_POINT_LIGHTS];
+};
+
+/*!
+ * Uniform buffer with the camera and light data of a frame
+ * The buffer is written once per frame and bound to a fixed binding point, which every scene shader
+ * declares for its FrameData block, so no per-frame uniforms have to be set per shader program.
+ */
+class FrameUniforms
+{
+protected:
+	GLuint _buffer;
+	FrameData _data;
+
+public:
+	/*!
+	 * Binding point of the FrameData block, layout(std140, binding = 0) in the shaders
+	 */
+	static const GLuint BINDING = 0;
+
+	/*!
+	 * Creates the uniform buffer
+	 */
+	FrameUniforms();
+	~FrameUniforms();
+
+	FrameUniforms(const FrameUniforms&) = delete;
+	FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+	/*!
+	 * Writes the data of the frame into the buffer and binds it to the binding point
+	 * Disabled lights are skipped, lights beyond the maximum are ignored.
+	 * @param camera: the camera
+	 * @param dirLights: the directional lights
+	 * @param pointLights: the point lights
+	 */
+	void update(Camera& camera, const std::vector<DirectionalLight>& dirLights, const std::vector<PointLight>& pointLights);
+};
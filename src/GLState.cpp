@@ -0,0 +1,234 @@
+#include "GLState.h"
+
+/*!
+ * Value of a name or enum in the shadow copy that is unknown, no OpenGL object or enum has this value
+ */
+static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+GLuint GLState::_program = UNKNOWN;
+GLuint GLState::_vertexArray = UNKNOWN;
+GLuint GLState::_buffers[BUFFER_TARGETS];
+GLuint GLState::_activeTexture = UNKNOWN;
+GLuint GLState::_textures[TEXTURE_UNITS][TEXTURE_TARGETS];
+int GLState::_capabilities[CAPABILITIES];
+GLenum GLState::_blendSource = UNKNOWN;
+GLenum GLState::_blendDestination = UNKNOWN;
+GLenum GLState::_depthFunc = UNKNOWN;
+int GLState::_depthMask = -1;
+int GLState::_colorMask = -1;
+GLenum GLState::_polygonMode = UNKNOWN;
+GLStateStats GLState::_stats = { 0, 0 };
+
+/*!
+ * Sets up the unknown state of the arrays before main
+ */
+static struct GLStateInitializer {
+	GLStateInitializer() { GLState::invalidate(); }
+} glStateInitializer;
+
+/* --------------------------------------------- */
+// Shadow copy
+/* --------------------------------------------- */
+
+int GLState::textureTargetIndex(GLenum target)
+{
+	switch (target) {
+	case GL_TEXTURE_2D: return 0;
+	case GL_TEXTURE_CUBE_MAP: return 1;
+	case GL_TEXTURE_2D_ARRAY: return 2;
+	default: return -1;
+	}
+}
+
+int GLState::bufferTargetIndex(GLenum target)
+{
+	switch (target) {
+	case GL_ARRAY_BUFFER: return 0;
+	case GL_UNIFORM_BUFFER: return 1;
+	case GL_COPY_READ_BUFFER: return 2;
+	case GL_COPY_WRITE_BUFFER: return 3;
+	case GL_PIXEL_UNPACK_BUFFER: return 4;
+	default: return -1;
+	}
+}
+
+int GLState::capabilityIndex(GLenum capability)
+{
+	switch (capability) {
+	case GL_BLEND: return 0;
+	case GL_DEPTH_TEST: return 1;
+	case GL_CULL_FACE: return 2;
+	default: return -1;
+	}
+}
+
+void GLState::invalidate()
+{
+	_program = UNKNOWN;
+	_vertexArray = UNKNOWN;
+	for (unsigned int i = 0; i < BUFFER_TARGETS; i++) _buffers[i] = UNKNOWN;
+	_activeTexture = UNKNOWN;
+	for (unsigned int unit = 0; unit < TEXTURE_UNITS; unit++) {
+		for (unsigned int target = 0; target < TEXTURE_TARGETS; target++) _textures[unit][target] = UNKNOWN;
+	}
+	for (unsigned int i = 0; i < CAPABILITIES; i++) _capabilities[i] = -1;
+	_blendSource = UNKNOWN;
+	_blendDestination = UNKNOWN;
+	_depthFunc = UNKNOWN;
+	_depthMask = -1;
+	_colorMask = -1;
+	_polygonMode = UNKNOWN;
+}
+
+/* --------------------------------------------- */
+// Bindings
+/* --------------------------------------------- */
+
+void GLState::useProgram(GLuint program)
+{
+	if (change(_program, program)) glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vertexArray)
+{
+	if (change(_vertexArray, vertexArray)) glBindVertexArray(vertexArray);
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+	int index = bufferTargetIndex(target);
+	if (index < 0) {
+		_stats.issued++;
+		glBindBuffer(target, buffer);
+	}
+	else if (change(_buffers[index], buffer)) {
+		glBindBuffer(target, buffer);
+	}
+}
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	// indexed bindings are not tracked, but the call changes the generic binding
+	_stats.issued++;
+	glBindBufferBase(target, index, buffer);
+	int targetIndex = bufferTargetIndex(target);
+	if (targetIndex >= 0) _buffers[targetIndex] = buffer;
+}
+
+void GLState::activeTexture(unsigned int unit)
+{
+	if (change(_activeTexture, GLuint(unit))) glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture)
+{
+	int index = textureTargetIndex(target);
+	if (index < 0 || _activeTexture >= TEXTURE_UNITS) {
+		_stats.issued++;
+		glBindTexture(target, texture);
+		if (index >= 0) {
+			// the active unit is unknown, so is the binding of this target on any unit
+			for (unsigned int unit = 0; unit < TEXTURE_UNITS; unit++) _textures[unit][index] = UNKNOWN;
+		}
+	}
+	else if (change(_textures[_activeTexture][index], texture)) {
+		glBindTexture(target, texture);
+	}
+}
+
+void GLState::bindTexture(unsigned int unit, GLenum target, GLuint texture)
+{
+	int index = textureTargetIndex(target);
+	if (index >= 0 && unit < TEXTURE_UNITS && _textures[unit][index] == texture) {
+		_stats.filtered++;
+		return;
+	}
+	activeTexture(unit);
+	bindTexture(target, texture);
+}
+
+/* --------------------------------------------- */
+// Fixed function state
+/* --------------------------------------------- */
+
+void GLState::setEnabled(GLenum capability, bool enabled)
+{
+	int index = capabilityIndex(capability);
+	if (index < 0) {
+		_stats.issued++;
+	}
+	else if (!change(_capabilities[index], enabled ? 1 : 0)) {
+		return;
+	}
+	if (enabled) glEnable(capability);
+	else glDisable(capability);
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination)
+{
+	if (_blendSource == source && _blendDestination == destination) {
+		_stats.filtered++;
+		return;
+	}
+	_blendSource = source;
+	_blendDestination = destination;
+	_stats.issued++;
+	glBlendFunc(source, destination);
+}
+
+void GLState::depthFunc(GLenum func)
+{
+	if (change(_depthFunc, func)) glDepthFunc(func);
+}
+
+void GLState::depthMask(bool write)
+{
+	if (change(_depthMask, write ? 1 : 0)) glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::colorMask(bool write)
+{
+	GLboolean value = write ? GL_TRUE : GL_FALSE;
+	if (change(_colorMask, write ? 1 : 0)) glColorMask(value, value, value, value);
+}
+
+void GLState::polygonMode(GLenum mode)
+{
+	if (change(_polygonMode, mode)) glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+/* --------------------------------------------- */
+// Deletion
+/* --------------------------------------------- */
+
+void GLState::deleteTextures(GLsizei count, const GLuint* textures)
+{
+	for (GLsizei i = 0; i < count; i++) {
+		if (textures[i] == 0) continue;
+		for (unsigned int unit = 0; unit < TEXTURE_UNITS; unit++) {
+			for (unsigned int target = 0; target < TEXTURE_TARGETS; target++) {
+				if (_textures[unit][target] == textures[i]) _textures[unit][target] = 0;
+			}
+		}
+	}
+	glDeleteTextures(count, textures);
+}
+
+void GLState::deleteBuffers(GLsizei count, const GLuint* buffers)
+{
+	for (GLsizei i = 0; i < count; i++) {
+		if (buffers[i] == 0) continue;
+		for (unsigned int target = 0; target < BUFFER_TARGETS; target++) {
+			if (_buffers[target] == buffers[i]) _buffers[target] = 0;
+		}
+	}
+	glDeleteBuffers(count, buffers);
+}
+
+void GLState::deleteVertexArrays(GLsizei count, const GLuint* vertexArrays)
+{
+	for (GLsizei i = 0; i < count; i++) {
+		if (vertexArrays[i] != 0 && _vertexArray == vertexArrays[i]) _vertexArray = 0;
+	}
+	glDeleteVertexArrays(count, vertexArrays);
+}
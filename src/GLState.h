@@ -0,0 +1,148 @@
+#pragma once
+
+#include <GL\glew.h>
+
+/*!
+ * Counts the state calls that went through GLState
+ */
+struct GLStateStats {
+	/*!
+	 * Calls passed on to the driver
+	 */
+	size_t issued;
+	/*!
+	 * Calls dropped because the state was already set
+	 */
+	size_t filtered;
+};
+
+/*!
+ * Shadow copy of the OpenGL state, filters redundant state calls on the CPU
+ * All program, VAO, buffer, texture, blend, depth, color mask, cull and polygon mode changes have to go through these functions,
+ * a direct GL call makes the shadow copy wrong. Code that cannot be changed (e.g. library code) has to call invalidate().
+ * Deleting objects through GLState resets the bindings the driver resets, so recycled names are bound again.
+ * The state is unknown at first, so the first call of every kind is always issued.
+ */
+class GLState
+{
+protected:
+	/*!
+	 * Number of texture units and texture targets (2D, cubemap, 2D array) in the shadow copy
+	 */
+	static const unsigned int TEXTURE_UNITS = 16;
+	static const unsigned int TEXTURE_TARGETS = 3;
+	/*!
+	 * Number of buffer targets in the shadow copy, the element array buffer is VAO state and never filtered
+	 */
+	static const unsigned int BUFFER_TARGETS = 5;
+	/*!
+	 * Number of capabilities in the shadow copy (blend, depth test, cull face)
+	 */
+	static const unsigned int CAPABILITIES = 3;
+
+	static GLuint _program;
+	static GLuint _vertexArray;
+	static GLuint _buffers[BUFFER_TARGETS];
+	static GLuint _activeTexture;
+	static GLuint _textures[TEXTURE_UNITS][TEXTURE_TARGETS];
+	/*!
+	 * 0 = disabled, 1 = enabled, -1 = unknown
+	 */
+	static int _capabilities[CAPABILITIES];
+	static GLenum _blendSource, _blendDestination;
+	static GLenum _depthFunc;
+	static int _depthMask;
+	static int _colorMask;
+	static GLenum _polygonMode;
+
+	static GLStateStats _stats;
+
+	/*!
+	 * Counts a call and stores the new value
+	 * @return if the call has to be issued, i.e. the value changed
+	 */
+	template<typename T>
+	static bool change(T& current, T value)
+	{
+		if (current == value) {
+			_stats.filtered++;
+			return false;
+		}
+		current = value;
+		_stats.issued++;
+		return true;
+	}
+
+	/*!
+	 * @return the index of a texture target in the shadow copy, -1 if it is not tracked
+	 */
+	static int textureTargetIndex(GLenum target);
+	/*!
+	 * @return the index of a buffer target in the shadow copy, -1 if it is not tracked
+	 */
+	static int bufferTargetIndex(GLenum target);
+	/*!
+	 * @return the index of a capability in the shadow copy, -1 if it is not tracked
+	 */
+	static int capabilityIndex(GLenum capability);
+
+public:
+	/*!
+	 * Forgets the shadow copy, the next call of every kind is issued
+	 */
+	static void invalidate();
+
+	static void useProgram(GLuint program);
+	static void bindVertexArray(GLuint vertexArray);
+	static void bindBuffer(GLenum target, GLuint buffer);
+	/*!
+	 * Binds a buffer to an indexed binding point, which also binds it to the generic target
+	 */
+	static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+	/*!
+	 * Selects the texture unit that bindTexture(target, texture) binds to
+	 */
+	static void activeTexture(unsigned int unit);
+	/*!
+	 * Binds a texture to the active texture unit
+	 */
+	static void bindTexture(GLenum target, GLuint texture);
+	/*!
+	 * Binds a texture to a texture unit
+	 */
+	static void bindTexture(unsigned int unit, GLenum target, GLuint texture);
+
+	static void setEnabled(GLenum capability, bool enabled);
+	static void enable(GLenum capability) { setEnabled(capability, true); }
+	static void disable(GLenum capability) { setEnabled(capability, false); }
+	static void blendFunc(GLenum source, GLenum destination);
+	static void depthFunc(GLenum func);
+	static void depthMask(bool write);
+	/*!
+	 * Enables or disables writing of all color channels
+	 */
+	static void colorMask(bool write);
+	/*!
+	 * Sets the polygon mode of front and back faces
+	 */
+	static void polygonMode(GLenum mode);
+
+	/*!
+	 * Deletes textures and unbinds them in the shadow copy
+	 */
+	static void deleteTextures(GLsizei count, const GLuint* textures);
+	/*!
+	 * Deletes buffers and unbinds them in the shadow copy
+	 */
+	static void deleteBuffers(GLsizei count, const GLuint* buffers);
+	/*!
+	 * Deletes vertex arrays and unbinds them in the shadow copy
+	 */
+	static void deleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+
+	/*!
+	 * @return the number of issued and filtered calls since the program started
+	 */
+	static const GLStateStats& getStats() { return _stats; }
+};
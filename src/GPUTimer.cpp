@@ -0,0 +1,54 @@
+#include "GPUTimer.h"
+
+/* --------------------------------------------- */
+// GPU timer
+/* --------------------------------------------- */
+
+GPUTimer::GPUTimer()
+	: _next(0), _running(false), _milliseconds(0.0), _samples(0)
+{
+	glGenQueries(QUERIES, _queries);
+	for (unsigned int i = 0; i < QUERIES; i++) _pending[i] = false;
+}
+
+GPUTimer::~GPUTimer()
+{
+	glDeleteQueries(QUERIES, _queries);
+}
+
+void GPUTimer::collect()
+{
+	for (unsigned int i = 0; i < QUERIES; i++) {
+		if (!_pending[i]) continue;
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE) continue;
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(_queries[i], GL_QUERY_RESULT, &nanoseconds);
+		_milliseconds += double(nanoseconds) * 1e-6;
+		_samples++;
+		_pending[i] = false;
+	}
+}
+
+void GPUTimer::begin()
+{
+	collect();
+	_running = !_pending[_next];
+	if (_running) glBeginQuery(GL_TIME_ELAPSED, _queries[_next]);
+}
+
+void GPUTimer::end()
+{
+	if (!_running) return;
+	glEndQuery(GL_TIME_ELAPSED);
+	_pending[_next] = true;
+	_next = (_next + 1) % QUERIES;
+	_running = false;
+}
+
+void GPUTimer::reset()
+{
+	_milliseconds = 0.0;
+	_samples = 0;
+}
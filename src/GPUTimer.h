@@ -0,0 +1,61 @@
+#pragma once
+
+#include <GL\glew.h>
+
+/*!
+ * Measures the GPU time of the commands between begin() and end() with GL_TIME_ELAPSED queries
+ * The queries of the last frames are kept in a ring and only read once their result is available, so the CPU never waits.
+ * If all queries are still in flight, the frame is not measured. Time elapsed queries cannot nest,
+ * so the ranges of different timers must not overlap.
+ */
+class GPUTimer
+{
+protected:
+	/*!
+	 * Number of queries in flight, the GPU may be this many frames behind before frames are skipped
+	 */
+	static const unsigned int QUERIES = 4;
+
+	GLuint _queries[QUERIES];
+	bool _pending[QUERIES];
+	unsigned int _next;
+	/*!
+	 * If begin() started a query that end() has to end
+	 */
+	bool _running;
+	/*!
+	 * Sum and number of the results read since the last reset
+	 */
+	double _milliseconds;
+	unsigned int _samples;
+
+	/*!
+	 * Adds the results of all finished queries to the sum
+	 */
+	void collect();
+
+public:
+	GPUTimer();
+	~GPUTimer();
+
+	GPUTimer(const GPUTimer&) = delete;
+	GPUTimer& operator=(const GPUTimer&) = delete;
+
+	/*!
+	 * Starts measuring, the results of earlier frames that arrived are collected first
+	 */
+	void begin();
+	/*!
+	 * Stops measuring
+	 */
+	void end();
+
+	/*!
+	 * @return the average GPU time in milliseconds of the results read since the last reset, 0 if there are none
+	 */
+	double getAverage() const { return _samples > 0 ? _milliseconds / _samples : 0.0; }
+	/*!
+	 * Forgets the results read so far, e.g. once per second
+	 */
+	void reset();
+};
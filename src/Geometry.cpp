@@ -5,76 +5,277 @@
 */
 
 #include "Geometry.h"
+#include <glm/gtc/packing.hpp>
+#include "OBJLoader.h"
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+#include "GLState.h"
+
+/* --------------------------------------------- */
+// Uniforms
+/* --------------------------------------------- */
+
+static const UniformId MODEL_MATRIX("modelMatrix");
+static const UniformId NORMAL_MATRIX("normalMatrix");
+static const UniformId INSTANCED("instanced");
+
+/* --------------------------------------------- */
+// Vertex compression
+/* --------------------------------------------- */
+
+static glm::vec2 signNotZero(glm::vec2 v)
+{
+	return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+glm::vec2 octahedralEncode(glm::vec3 n)
+{
+	float l1 = glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+	if (l1 == 0.0f) return glm::vec2(0.0f);
+	glm::vec2 e = glm::vec2(n.x, n.y) / l1;
+	// fold the lower hemisphere over the diagonals
+	if (n.z < 0.0f) e = (1.0f - glm::abs(glm::vec2(e.y, e.x))) * signNotZero(e);
+	return e;
+}
+
+glm::vec3 octahedralDecode(glm::vec2 e)
+{
+	glm::vec3 n = glm::vec3(e.x, e.y, 1.0f - glm::abs(e.x) - glm::abs(e.y));
+	if (n.z < 0.0f) {
+		glm::vec2 xy = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * signNotZero(glm::vec2(n.x, n.y));
+		n.x = xy.x;
+		n.y = xy.y;
+	}
+	return glm::normalize(n);
+}
+
+/* --------------------------------------------- */
+// Bounds
+/* --------------------------------------------- */
+
+Bounds Bounds::fromPoints(const std::vector<glm::vec3>& positions)
+{
+	Bounds bounds;
+	bounds.min = positions.empty() ? glm::vec3(0.0f) : positions[0];
+	bounds.max = bounds.min;
+	for (const glm::vec3& position : positions) {
+		bounds.min = glm::min(bounds.min, position);
+		bounds.max = glm::max(bounds.max, position);
+	}
+	bounds.center = 0.5f * (bounds.min + bounds.max);
+	// tighter than half the diagonal for round meshes
+	float radiusSquared = 0.0f;
+	for (const glm::vec3& position : positions) {
+		glm::vec3 d = position - bounds.center;
+		radiusSquared = glm::max(radiusSquared, glm::dot(d, d));
+	}
+	bounds.radius = glm::sqrt(radiusSquared);
+	return bounds;
+}
+
+Bounds Bounds::fromBox(const glm::vec3& min, const glm::vec3& max)
+{
+	Bounds bounds;
+	bounds.min = min;
+	bounds.max = max;
+	bounds.center = 0.5f * (min + max);
+	bounds.radius = 0.5f * glm::length(max - min);
+	return bounds;
+}
+
+/* --------------------------------------------- */
+// Geometry data
+/* --------------------------------------------- */
+
+size_t GeometryData::byteSize() const
+{
+	size_t vertexSize = 2 * sizeof(glm::vec3) + sizeof(glm::vec2);
+	if (layout == VertexLayout::INTERLEAVED_PACKED_NORMALS) vertexSize = sizeof(PackedNormalVertex);
+	else if (layout == VertexLayout::QUANTIZED) vertexSize = sizeof(QuantizedVertex);
+	return positions.size() * vertexSize + indices.size() * (hasShortIndices() ? sizeof(GLushort) : sizeof(unsigned int));
+}
+
+std::vector<InterleavedVertex> GeometryData::interleave() const
+{
+	std::vector<InterleavedVertex> vertices(positions.size());
+	for (size_t i = 0; i < vertices.size(); i++) {
+		vertices[i].position = positions[i];
+		vertices[i].normal = i < normals.size() ? normals[i] : glm::vec3(0.0f);
+		vertices[i].uv = i < UVs.size() ? UVs[i] : glm::vec2(0.0f);
+	}
+	return vertices;
+}
+
+std::vector<PackedNormalVertex> GeometryData::interleavePacked() const
+{
+	std::vector<PackedNormalVertex> vertices(positions.size());
+	for (size_t i = 0; i < vertices.size(); i++) {
+		vertices[i].position = positions[i];
+		vertices[i].normal = glm::packSnorm3x10_1x2(glm::vec4(i < normals.size() ? normals[i] : glm::vec3(0.0f), 0.0f));
+		vertices[i].uv = i < UVs.size() ? UVs[i] : glm::vec2(0.0f);
+	}
+	return vertices;
+}
+
+std::vector<QuantizedVertex> GeometryData::quantize(glm::vec3& positionOffset, glm::vec3& positionScale) const
+{
+	glm::vec3 boundsMin = positions.empty() ? glm::vec3(0.0f) : positions[0];
+	glm::vec3 boundsMax = boundsMin;
+	for (const glm::vec3& position : positions) {
+		boundsMin = glm::min(boundsMin, position);
+		boundsMax = glm::max(boundsMax, position);
+	}
+	positionOffset = boundsMin;
+	positionScale = boundsMax - boundsMin;
+	glm::vec3 inverseScale = glm::vec3(
+		positionScale.x > 0.0f ? 1.0f / positionScale.x : 0.0f,
+		positionScale.y > 0.0f ? 1.0f / positionScale.y : 0.0f,
+		positionScale.z > 0.0f ? 1.0f / positionScale.z : 0.0f);
+
+	std::vector<QuantizedVertex> vertices(positions.size());
+	for (size_t i = 0; i < vertices.size(); i++) {
+		glm::vec3 position = glm::clamp((positions[i] - positionOffset) * inverseScale, 0.0f, 1.0f);
+		vertices[i].position[0] = glm::packUnorm1x16(position.x);
+		vertices[i].position[1] = glm::packUnorm1x16(position.y);
+		vertices[i].position[2] = glm::packUnorm1x16(position.z);
+		vertices[i].position[3] = 0;
+
+		glm::vec2 normal = octahedralEncode(i < normals.size() ? normals[i] : glm::vec3(0.0f, 0.0f, 1.0f));
+		vertices[i].normal[0] = GLshort(glm::packSnorm1x16(normal.x));
+		vertices[i].normal[1] = GLshort(glm::packSnorm1x16(normal.y));
+
+		glm::vec2 uv = i < UVs.size() ? UVs[i] : glm::vec2(0.0f);
+		vertices[i].uv[0] = glm::packHalf1x16(uv.x);
+		vertices[i].uv[1] = glm::packHalf1x16(uv.y);
+	}
+	return vertices;
+}
+
+/* --------------------------------------------- */
+// Geometry
+/* --------------------------------------------- */
+
+const float Geometry::LOD_SCREEN_SIZE = 0.25f;
+const float Geometry::LOD_HYSTERESIS = 0.1f;
 
 Geometry::Geometry(glm::mat4 modelMatrix, GeometryData& data, std::shared_ptr<Material> material)
-	: _elements(data.indices.size()), _modelMatrix(modelMatrix), _material(material)
+	: _mesh(std::make_shared<Mesh>(data)), _lod(0), _material(material), _modelMatrix(modelMatrix), _normalMatrixDirty(true)
 {
-	// create VAO
-	glGenVertexArrays(1, &_vao);
-	glBindVertexArray(_vao);
-
-	// create positions VBO
-	glGenBuffers(1, &_vboPositions);
-	glBindBuffer(GL_ARRAY_BUFFER, _vboPositions);
-	glBufferData(GL_ARRAY_BUFFER, data.positions.size() * sizeof(glm::vec3), data.positions.data(), GL_STATIC_DRAW);
-
-	// bind positions to location 0
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-	// create normals VBO
-	glGenBuffers(1, &_vboNormals);
-	glBindBuffer(GL_ARRAY_BUFFER, _vboNormals);
-	glBufferData(GL_ARRAY_BUFFER, data.normals.size() * sizeof(glm::vec3), data.normals.data(), GL_STATIC_DRAW);
-
-	// bind normals to location 1
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-	// create UVs VBO
-	glGenBuffers(1, &_vboUVs);
-	glBindBuffer(GL_ARRAY_BUFFER, _vboUVs);
-	glBufferData(GL_ARRAY_BUFFER, data.UVs.size() * sizeof(glm::vec2), data.UVs.data(), GL_STATIC_DRAW);
-
-	// bind UVs to location 2
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-	// create and bind indices VBO
-	glGenBuffers(1, &_vboIndices);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _vboIndices);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(unsigned int), data.indices.data(), GL_STATIC_DRAW);
-
-	glBindVertexArray(0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-Geometry::~Geometry()
+Geometry::Geometry(glm::mat4 modelMatrix, const MeshCacheFile& file, std::shared_ptr<Material> material)
+	: _mesh(std::make_shared<Mesh>(file)), _lod(0), _material(material), _modelMatrix(modelMatrix), _normalMatrixDirty(true)
+{
+}
+
+Geometry::Geometry(glm::mat4 modelMatrix, std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material)
+	: _mesh(mesh), _lod(0), _material(material), _modelMatrix(modelMatrix), _normalMatrixDirty(true)
 {
-	glDeleteBuffers(1, &_vboPositions);
-	glDeleteBuffers(1, &_vboIndices);
-	glDeleteBuffers(1, &_vboNormals);
-	glDeleteBuffers(1, &_vboIndices);
-	glDeleteVertexArrays(1, &_vao);
 }
 
 void Geometry::draw()
 {
 	Shader* shader = _material->getShader();
-	shader->use();
+	GLState::useProgram(shader->getHandle());
 
-	shader->setUniform("modelMatrix", _modelMatrix);
-	shader->setUniform("normalMatrix", glm::mat3(glm::transpose(glm::inverse(_modelMatrix))));
+	shader->setUniform(MODEL_MATRIX, _modelMatrix);
+	shader->setUniform(NORMAL_MATRIX, getNormalMatrix());
+	shader->setUniform(INSTANCED, 0);
+	_mesh->setUniforms(shader);
 	_material->setUniforms();
+	_material->bindTextures();
+
+	_mesh->draw();
+}
+
+glm::mat3 Geometry::getNormalMatrix() const
+{
+	if (_normalMatrixDirty) {
+		_normalMatrix = computeNormalMatrix(_modelMatrix);
+		_normalMatrixDirty = false;
+	}
+	return _normalMatrix;
+}
+
+glm::mat3 Geometry::computeNormalMatrix(const glm::mat4& modelMatrix)
+{
+	glm::mat3 m = glm::mat3(modelMatrix);
+	float lengths[3] = { glm::dot(m[0], m[0]), glm::dot(m[1], m[1]), glm::dot(m[2], m[2]) };
+
+	// with orthogonal columns m = R * S, so the inverse transpose is R * S^-1, i.e. every column divided by its squared length
+	const float epsilon = 1e-5f;
+	bool orthogonal = lengths[0] > 0.0f && lengths[1] > 0.0f && lengths[2] > 0.0f
+		&& glm::abs(glm::dot(m[0], m[1])) <= epsilon * glm::sqrt(lengths[0] * lengths[1])
+		&& glm::abs(glm::dot(m[0], m[2])) <= epsilon * glm::sqrt(lengths[0] * lengths[2])
+		&& glm::abs(glm::dot(m[1], m[2])) <= epsilon * glm::sqrt(lengths[1] * lengths[2]);
+	if (orthogonal) {
+		return glm::mat3(m[0] / lengths[0], m[1] / lengths[1], m[2] / lengths[2]);
+	}
+
+	// shear: general inverse
+	return glm::transpose(glm::inverse(m));
+}
+
+const Bounds& Geometry::getMeshBounds() const
+{
+	return !_lods.empty() && _lods[0]->isReady() ? _lods[0]->getBounds() : _mesh->getBounds();
+}
+
+glm::vec4 Geometry::getBoundingSphere() const
+{
+	const Bounds& bounds = getMeshBounds();
+	glm::vec3 center = glm::vec3(_modelMatrix * glm::vec4(bounds.center, 1.0f));
+	float scaleSquared = glm::max(glm::dot(glm::vec3(_modelMatrix[0]), glm::vec3(_modelMatrix[0])),
+		glm::max(glm::dot(glm::vec3(_modelMatrix[1]), glm::vec3(_modelMatrix[1])), glm::dot(glm::vec3(_modelMatrix[2]), glm::vec3(_modelMatrix[2]))));
+	return glm::vec4(center, bounds.radius * glm::sqrt(scaleSquared));
+}
+
+void Geometry::setLODs(const std::vector<std::shared_ptr<Mesh>>& lods)
+{
+	_lods = lods;
+	_lod = 0;
+	if (!_lods.empty()) _mesh = _lods[0];
+}
 
-	glBindVertexArray(_vao);
-	glDrawElements(GL_TRIANGLES, _elements, GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+size_t Geometry::selectLOD(size_t current, size_t count, float screenSize)
+{
+	// level i is used below LOD_SCREEN_SIZE / 2^(i - 1)
+	auto switchSize = [](size_t lod) { return LOD_SCREEN_SIZE / float(1u << (lod - 1)); };
+	while (current > 0 && screenSize > switchSize(current) * (1.0f + LOD_HYSTERESIS)) current--;
+	while (current + 1 < count && screenSize < switchSize(current + 1) * (1.0f - LOD_HYSTERESIS)) current++;
+	return current;
+}
+
+size_t Geometry::selectLOD(float screenSize)
+{
+	if (_lods.size() < 2) return _lod;
+	_lod = selectLOD(_lod, _lods.size(), screenSize);
+
+	// draw the closest level that is uploaded, a finer one if there is a tie
+	_mesh = _lods[_lod];
+	for (size_t distance = 1; !_mesh->isReady() && distance < _lods.size(); distance++) {
+		if (_lod >= distance && _lods[_lod - distance]->isReady()) _mesh = _lods[_lod - distance];
+		else if (_lod + distance < _lods.size() && _lods[_lod + distance]->isReady()) _mesh = _lods[_lod + distance];
+	}
+	return _lod;
+}
+
+Bounds Geometry::getWorldBounds() const
+{
+	const Bounds& bounds = getMeshBounds();
+	glm::vec3 center = glm::vec3(_modelMatrix * glm::vec4(0.5f * (bounds.min + bounds.max), 1.0f));
+	glm::vec3 extent = 0.5f * (bounds.max - bounds.min);
+	// extent of the rotated box along each world axis
+	glm::vec3 worldExtent = glm::abs(glm::vec3(_modelMatrix[0])) * extent.x
+		+ glm::abs(glm::vec3(_modelMatrix[1])) * extent.y
+		+ glm::abs(glm::vec3(_modelMatrix[2])) * extent.z;
+	return Bounds::fromBox(center - worldExtent, center + worldExtent);
 }
 
 void Geometry::transform(glm::mat4 transformation)
 {
 	_modelMatrix = transformation * _modelMatrix;
+	_normalMatrixDirty = true;
 }
 
 /*void Geometry::rotate(float degree, glm::vec3 rotationAxis)
@@ -92,11 +293,12 @@ void Geometry::transform(glm::mat4 transformation)
 /*glm::vec3 Camera::getPosition()
 {
 	return glm::vec3();
-}
+}*/
 
 void Geometry::resetModelMatrix()
 {
 	_modelMatrix = glm::mat4(1);
+	_normalMatrixDirty = true;
 }
 
 GeometryData Geometry::createCubeGeometry(float width, float height, float depth)
@@ -223,6 +425,7 @@ GeometryData Geometry::createCubeGeometry(float width, float height, float depth
 		20, 21, 22,
 		22, 23, 20
 	};
+	data.computeBounds();
 
 	return std::move(data);
 }
@@ -291,6 +494,9 @@ GeometryData Geometry::createCylinderGeometry(unsigned int segments, float heigh
 		data.indices.push_back(5 + i * 4);
 	}
 
+	MeshOptimizer::optimize(data);
+	data.computeBounds();
+
 	return std::move(data);
 }
 
@@ -344,76 +550,16 @@ GeometryData Geometry::createSphereGeometry(unsigned int longitudeSegments, unsi
 		}
 	}
 
+	MeshOptimizer::optimize(data);
+	data.computeBounds();
+
 	return std::move(data);
 }
 
-/*GeometryData Geometry::createOBJGeometry(const char * path) {
-
+GeometryData Geometry::createOBJGeometry(const char* path)
+{
 	GeometryData data;
-	std::vector< unsigned int > vertexIndices, uvIndices, normalIndices;
-	std::vector< glm::vec3 > temp_vertices;
-	std::vector< glm::vec2 > temp_uvs;
-	std::vector< glm::vec3 > temp_normals;
-	FILE * file = fopen(path, "r");
-	if (file == NULL) {
-		printf("Impossible to open the file !\n");
-		return null;
-	}
-	else {
-		while (1) {
-
-			char lineHeader[128];
-			// read the first word of the line
-			int res = fscanf(file, "%s", lineHeader);
-			if (res == EOF) {
-				break; // EOF = End Of File. Quit the loop.
-			}
-			else {
-				if (strcmp(lineHeader, "v") == 0) {
-					glm::vec3 vertex;
-					fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
-					temp_vertices.push_back(vertex);
-				}
-				else if (strcmp(lineHeader, "vt") == 0) {
-					glm::vec2 uv;
-					fscanf(file, "%f %f\n", &uv.x, &uv.y);
-					temp_uvs.push_back(uv);
-				}
-				else if (strcmp(lineHeader, "vn") == 0) {
-					glm::vec3 normal;
-					fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
-					temp_normals.push_back(normal);
-				}
-				else if (strcmp(lineHeader, "f") == 0) {
-					std::string vertex1, vertex2, vertex3;
-					unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-					int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
-					if (matches != 9) {
-						printf("File can't be read by our simple parser : ( Try exporting with other options\n");
-						return false;
-					}
-					vertexIndices.push_back(vertexIndex[0]);
-					vertexIndices.push_back(vertexIndex[1]);
-					vertexIndices.push_back(vertexIndex[2]);
-					uvIndices.push_back(uvIndex[0]);
-					uvIndices.push_back(uvIndex[1]);
-					uvIndices.push_back(uvIndex[2]);
-					normalIndices.push_back(normalIndex[0]);
-					normalIndices.push_back(normalIndex[1]);
-					normalIndices.push_back(normalIndex[2]);
-
-					for (unsigned int i = 0; i < vertexIndices.size(); i++) {
-						unsigned int vertexIndex = vertexIndices[i];
-						glm::vec3 vertex = temp_vertices[vertexIndex - 1];
-						vertices.push_back(vertex)
-					}
-				}
-			}
-			return std::move(data);
-		}
-	}
-	
+	if (OBJLoader::load(path, data)) MeshOptimizer::optimize(data);
+	data.computeBounds();
+	return std::move(data);
 }
-*/
-
-
@@ -14,6 +14,103 @@
 #include "Material.h"
 #include "Shader.h"
 
+class MeshCacheFile;
+class Mesh;
+
+/*!
+ * One vertex with all attributes next to each other (32 bytes)
+ */
+struct InterleavedVertex {
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 uv;
+};
+
+/*!
+ * One vertex with the normal packed into 10 bit signed normalized components (24 bytes)
+ */
+struct PackedNormalVertex {
+	glm::vec3 position;
+	GLuint normal;
+	glm::vec2 uv;
+};
+
+/*!
+ * One compressed vertex (16 bytes)
+ * Position quantized to 16 bit relative to the mesh bounds, octahedral encoded
+ * normal in 2x16 bit signed normalized components and half float UVs.
+ */
+struct QuantizedVertex {
+	GLushort position[4];
+	GLshort normal[2];
+	GLushort uv[2];
+};
+
+/*!
+ * Encodes a unit vector with the octahedral mapping
+ * @param n: the unit vector
+ * @return the encoded vector in [-1, 1]^2
+ */
+glm::vec2 octahedralEncode(glm::vec3 n);
+
+/*!
+ * Decodes an octahedral encoded unit vector
+ * @param e: the encoded vector in [-1, 1]^2
+ * @return the unit vector
+ */
+glm::vec3 octahedralDecode(glm::vec2 e);
+
+/*!
+ * How the vertex attributes of a geometry object are stored on the GPU
+ */
+enum class VertexLayout {
+	/*!
+	 * One buffer per attribute
+	 */
+	SEPARATE,
+	/*!
+	 * One buffer with InterleavedVertex elements
+	 */
+	INTERLEAVED,
+	/*!
+	 * One buffer with PackedNormalVertex elements
+	 */
+	INTERLEAVED_PACKED_NORMALS,
+	/*!
+	 * One buffer with QuantizedVertex elements, decoded in the vertex shader
+	 */
+	QUANTIZED
+};
+
+/*!
+ * Axis aligned bounding box and bounding sphere of a set of points
+ */
+struct Bounds {
+	glm::vec3 min = glm::vec3(0.0f);
+	glm::vec3 max = glm::vec3(0.0f);
+	/*!
+	 * Bounding sphere around the center of the box, negative radius if the bounds were never computed
+	 */
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = -1.0f;
+
+	bool isValid() const { return radius >= 0.0f; }
+
+	/*!
+	 * Computes the box and the smallest sphere around its center that contains all points
+	 * @param positions: the points, empty points give a zero sized bounds at the origin
+	 * @return the bounds
+	 */
+	static Bounds fromPoints(const std::vector<glm::vec3>& positions);
+	/*!
+	 * Computes the bounds of a box, the sphere contains the whole box
+	 * @param min: minimum corner of the box
+	 * @param max: maximum corner of the box
+	 * @return the bounds
+	 */
+	static Bounds fromBox(const glm::vec3& min, const glm::vec3& max);
+};
+
 /*!
  * Stores all data for a geometry object
  */
@@ -33,38 +130,68 @@ struct GeometryData {
 	/*!
 	 * Vertex UV coordinates
 	 */
-	std::vector<glm::vec2> uvs;
-};
+	std::vector<glm::vec2> UVs;
+	/*!
+	 * How the vertices are uploaded to the GPU
+	 */
+	VertexLayout layout = VertexLayout::SEPARATE;
+	/*!
+	 * Bounds of the positions, computed by the create functions of Geometry
+	 */
+	Bounds bounds;
 
+	/*!
+	 * Computes the bounds of the positions, has to be called again after the positions changed
+	 */
+	void computeBounds() { bounds = Bounds::fromPoints(positions); }
 
-class Geometry
-{
-protected:
 	/*!
-	 * Vertex array object
+	 * @return if all indices fit into 16 bit, i.e. the index buffer can be uploaded as GL_UNSIGNED_SHORT
 	 */
-	GLuint _vao;
+	bool hasShortIndices() const { return positions.size() <= 0x10000; }
+
 	/*!
-	 * Vertex buffer object that stores the vertex positions
+	 * @return the size of the vertex and index buffers in bytes, as uploaded to the GPU
 	 */
-	GLuint _vboPositions;
+	size_t byteSize() const;
+
 	/*!
-	 * Vertex buffer object that stores the vertex normals
+	 * @return all vertices with their attributes interleaved
 	 */
-	GLuint _vboNormals;
+	std::vector<InterleavedVertex> interleave() const;
 	/*!
-	 * Vertex buffer object that stores the vertex UV coordinates
+	 * @return all vertices with their attributes interleaved and their normals packed
 	 */
-	GLuint _vboUVs;
+	std::vector<PackedNormalVertex> interleavePacked() const;
 	/*!
-	 * Vertex buffer object that stores the indices
+	 * Quantizes all vertices
+	 * @param positionOffset: the offset to add to the dequantized positions (the minimum of the bounds)
+	 * @param positionScale: the scale of the dequantized positions (the extent of the bounds)
+	 * @return all vertices in the compressed format
 	 */
-	GLuint _vboIndices;
+	std::vector<QuantizedVertex> quantize(glm::vec3& positionOffset, glm::vec3& positionScale) const;
+};
 
+
+/*!
+ * One instance of a mesh in the scene, i.e. the mesh with a model matrix and a material
+ */
+class Geometry
+{
+protected:
+	/*!
+	 * The GPU mesh, possibly shared with other instances
+	 */
+	std::shared_ptr<Mesh> _mesh;
+	/*!
+	 * Levels of detail, finest first (empty if the object only has one mesh)
+	 * _mesh is the selected level, or the closest level that is ready while it is streamed in.
+	 */
+	std::vector<std::shared_ptr<Mesh>> _lods;
 	/*!
-	 * Number of elements to be rendered
+	 * Index of the selected level of detail
 	 */
-	unsigned int _elements;
+	size_t _lod;
 
 	/*!
 	 * Material of the geometry object
@@ -76,17 +203,116 @@ protected:
 	 */
 	glm::mat4 _modelMatrix;
 
+	/*!
+	 * Normal matrix of the object, only recomputed after the model matrix changed
+	 */
+	mutable glm::mat3 _normalMatrix;
+	/*!
+	 * If the model matrix changed since the normal matrix was computed
+	 */
+	mutable bool _normalMatrixDirty;
+
+	/*!
+	 * @return the bounds of the finest level of detail once it is uploaded, they contain all coarser levels
+	 */
+	const Bounds& getMeshBounds() const;
+
 public:
 
 	/*!
 	 * Geometry object constructor
-	 * Creates VAO and VBOs and binds them
+	 * Creates a mesh that is used by this object only
 	 * @param modelMatrix: model matrix of the object
 	 * @param data: data for the geometry object
 	 * @param material: material of the geometry object
 	 */
 	Geometry(glm::mat4 modelMatrix, GeometryData& data, std::shared_ptr<Material> material);
-	~Geometry();
+	/*!
+	 * Geometry object constructor
+	 * Creates a mesh from a mapped mesh cache that is used by this object only
+	 * @param modelMatrix: model matrix of the object
+	 * @param file: the mapped mesh cache file
+	 * @param material: material of the geometry object
+	 */
+	Geometry(glm::mat4 modelMatrix, const MeshCacheFile& file, std::shared_ptr<Material> material);
+	/*!
+	 * Geometry object constructor
+	 * @param modelMatrix: model matrix of the object
+	 * @param mesh: the shared mesh to draw, e.g. from a MeshRegistry
+	 * @param material: material of the geometry object
+	 */
+	Geometry(glm::mat4 modelMatrix, std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material);
+
+	/*!
+	 * Screen size below which the first coarser level of detail is used, every further level halves it
+	 * The screen size is the projected diameter of the bounding sphere relative to the screen, see Camera::getScreenSize().
+	 */
+	static const float LOD_SCREEN_SIZE;
+	/*!
+	 * Relative margin around the switch sizes, a level only changes once the size left the margin, so objects
+	 * moving back and forth at a switch size do not pop
+	 */
+	static const float LOD_HYSTERESIS;
+
+	/*!
+	 * Sets the levels of detail
+	 * @param lods: the meshes, finest first, e.g. from MeshRegistry::getLODs()
+	 */
+	void setLODs(const std::vector<std::shared_ptr<Mesh>>& lods);
+	/*!
+	 * Selects the level of detail for the current screen size of the object
+	 * @param screenSize: projected diameter of the bounding sphere relative to the screen
+	 * @return the selected level
+	 */
+	size_t selectLOD(float screenSize);
+	/*!
+	 * Selects a level of detail with hysteresis
+	 * @param current: the level selected so far
+	 * @param count: the number of levels
+	 * @param screenSize: projected diameter of the bounding sphere relative to the screen
+	 * @return the new level
+	 */
+	static size_t selectLOD(size_t current, size_t count, float screenSize);
+	/*!
+	 * @return the selected level of detail, 0 is the finest
+	 */
+	size_t getLOD() const { return _lod; }
+	/*!
+	 * @return the number of levels of detail, 1 if the object only has one mesh
+	 */
+	size_t getLODCount() const { return _lods.empty() ? 1 : _lods.size(); }
+
+	/*!
+	 * @return the mesh of the object, the selected level of detail
+	 */
+	std::shared_ptr<Mesh> getMesh() const { return _mesh; }
+	/*!
+	 * @return the material of the object
+	 */
+	std::shared_ptr<Material> getMaterial() const { return _material; }
+	/*!
+	 * @return the normal matrix of the object, i.e. the inverse transpose of the model matrix
+	 */
+	glm::mat3 getNormalMatrix() const;
+	/*!
+	 * Transforms the bounding sphere of the mesh into world space
+	 * The radius is scaled by the largest axis scale of the model matrix, so the sphere stays conservative.
+	 * @return center (xyz) and radius (w) of the bounding sphere in world space
+	 */
+	glm::vec4 getBoundingSphere() const;
+	/*!
+	 * Transforms the bounding box of the mesh into world space
+	 * @return the axis aligned box around the transformed box
+	 */
+	Bounds getWorldBounds() const;
+
+	/*!
+	 * Computes the inverse transpose of the upper 3x3 part of a model matrix
+	 * Rigid transforms and scales along the axes of the rotation (orthogonal columns) take a fast path.
+	 * @param modelMatrix: the model matrix
+	 * @return the normal matrix
+	 */
+	static glm::mat3 computeNormalMatrix(const glm::mat4& modelMatrix);
 
 	/*!
 	 * Draws the object
@@ -105,7 +331,7 @@ public:
 	// */
 	//glm::mat4 getModelMatrix();
 
-	glm::mat4 Geometry::getModelMatrix()
+	glm::mat4 Geometry::getModelMatrix() const
 	{
 		// print cubeMatrix to console
 		//cout << "geometry.h\n";
@@ -143,83 +369,10 @@ public:
 	 */
 	static GeometryData createSphereGeometry(unsigned int longitudeSegments, unsigned int latitudeSegments, float radius);
 
-	static GeometryData createOBJGeometry(const char * path) {
-
-		GeometryData data;
-		std::vector< unsigned int > vertexIndices, uvIndices, normalIndices;
-		std::vector< glm::vec3 > temp_vertices;
-		std::vector< glm::vec2 > temp_uvs;
-		std::vector< glm::vec3 > temp_normals;
-		FILE * file = fopen(path, "r");
-		if (file == NULL) {
-			printf("Impossible to open the file !\n");
-		}
-		else {
-			while (1) {
-
-				char lineHeader[128];
-				// read the first word of the line
-				int res = fscanf(file, "%s", lineHeader);
-				if (res == EOF) {
-					break; // EOF = End Of File. Quit the loop.
-				}
-				else {
-					if (strcmp(lineHeader, "v") == 0) {
-						glm::vec3 vertex;
-						fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
-						temp_vertices.push_back(vertex);
-					}
-					else if (strcmp(lineHeader, "vt") == 0) {
-						glm::vec2 uv;
-						fscanf(file, "%f %f\n", &uv.x, &uv.y);
-						temp_uvs.push_back(uv);
-					}
-					else if (strcmp(lineHeader, "vn") == 0) {
-						glm::vec3 normal;
-						fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
-						temp_normals.push_back(normal);
-					}
-					else if (strcmp(lineHeader, "f") == 0) {
-						std::string vertex1, vertex2, vertex3;
-						unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-						int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
-						if (matches != 9) {
-							printf("File can't be read by our simple parser : ( Try exporting with other options\n");
-						}
-						vertexIndices.push_back(vertexIndex[0]);
-						vertexIndices.push_back(vertexIndex[1]);
-						vertexIndices.push_back(vertexIndex[2]);
-						uvIndices.push_back(uvIndex[0]);
-						uvIndices.push_back(uvIndex[1]);
-						uvIndices.push_back(uvIndex[2]);
-						normalIndices.push_back(normalIndex[0]);
-						normalIndices.push_back(normalIndex[1]);
-						normalIndices.push_back(normalIndex[2]);
-
-
-					}
-				}
-			}
-			for (unsigned int i = 0; i < vertexIndices.size(); i++) {
-				unsigned int vertexIndex = vertexIndices[i];
-				glm::vec3 vertex = temp_vertices[vertexIndex - 1];
-				data.positions.push_back(vertex);
-				data.indices.push_back(i);
-
-			}
-			for (unsigned int i = 0; i < uvIndices.size(); i++) {
-				unsigned int uvIndex = uvIndices[i];
-				glm::vec2 uv = temp_uvs[uvIndex - 1];
-				data.uvs.push_back(uv);
-
-			}
-			for (unsigned int i = 0; i < normalIndices.size(); i++) {
-				unsigned int normalIndex = normalIndices[i];
-				glm::vec3 normal = temp_normals[normalIndex - 1];
-				data.normals.push_back(normal);
-
-				return std::move(data);
-			}
-		}
-	}
+	/*!
+	 * Loads a geometry from a Wavefront OBJ file
+	 * @param path: path to the OBJ file
+	 * @return all geometry data of the file (empty if it could not be loaded)
+	 */
+	static GeometryData createOBJGeometry(const char* path);
 };
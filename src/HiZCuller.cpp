@@ -0,0 +1,192 @@
+#include "HiZCuller.h"
+#include <algorithm>
+#include <iostream>
+#include "GLState.h"
+#include "Mesh.h"
+
+static const UniformId MODEL_MATRIX("modelMatrix");
+static const UniformId VIEW_PROJ_MATRIX("viewProjMatrix");
+static const UniformId BOX_COUNT("boxCount");
+static const UniformId HI_Z("hiZ");
+
+/*!
+ * Work group sizes, have to match local_size in hiz_build.comp and hiz_test.comp
+ */
+static const GLuint BUILD_GROUP_SIZE = 8;
+static const GLuint TEST_GROUP_SIZE = 64;
+/*!
+ * Texture unit the test reads the pyramid from
+ */
+static const unsigned int HI_Z_UNIT = 0;
+
+/* --------------------------------------------- */
+// Hi-Z culler
+/* --------------------------------------------- */
+
+HiZCuller::HiZCuller(unsigned int width, unsigned int height)
+	: _width(width), _height(height), _levels(1), _framebuffer(0), _depthBuffer(0), _hiZTexture(0), _boxBuffer(0), _boxCapacity(0),
+	_resultCapacity(0), _nextResult(0), _occluderShader(Shader::create("occluder.vert", "occluder.frag")),
+	_buildShader("hiz_build.comp"), _testShader("hiz_test.comp")
+{
+	while ((std::max(width, height) >> _levels) > 0) _levels++;
+	for (unsigned int i = 0; i < RESULT_BUFFERS; i++) {
+		_fences[i] = 0;
+		_resultCounts[i] = 0;
+	}
+	for (int i = 0; i < 4; i++) _viewport[i] = 0;
+
+	glGenTextures(1, &_hiZTexture);
+	GLState::bindTexture(HI_Z_UNIT, GL_TEXTURE_2D, _hiZTexture);
+	glTexStorage2D(GL_TEXTURE_2D, _levels, GL_R32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	GLState::bindTexture(HI_Z_UNIT, GL_TEXTURE_2D, 0);
+
+	glGenRenderbuffers(1, &_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, _depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _hiZTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "ERROR: The occluder framebuffer is incomplete" << std::endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glGenBuffers(1, &_boxBuffer);
+	glGenBuffers(RESULT_BUFFERS, _resultBuffers);
+	if (_testShader.isValid()) _testShader.setUniform(HI_Z, int(HI_Z_UNIT));
+}
+
+HiZCuller::~HiZCuller()
+{
+	for (unsigned int i = 0; i < RESULT_BUFFERS; i++) {
+		if (_fences[i] != 0) glDeleteSync(_fences[i]);
+	}
+	GLState::deleteBuffers(RESULT_BUFFERS, _resultBuffers);
+	GLState::deleteBuffers(1, &_boxBuffer);
+	glDeleteFramebuffers(1, &_framebuffer);
+	glDeleteRenderbuffers(1, &_depthBuffer);
+	GLState::deleteTextures(1, &_hiZTexture);
+}
+
+void HiZCuller::setBox(size_t object, const glm::vec3& min, const glm::vec3& max)
+{
+	if (2 * object + 1 >= _boxes.size()) _boxes.resize(2 * object + 2, glm::vec4(0.0f));
+	_boxes[2 * object] = glm::vec4(min, 0.0f);
+	_boxes[2 * object + 1] = glm::vec4(max, 0.0f);
+}
+
+void HiZCuller::beginOccluders()
+{
+	glGetIntegerv(GL_VIEWPORT, _viewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	glViewport(0, 0, _width, _height);
+	GLState::polygonMode(GL_FILL);
+	GLState::disable(GL_BLEND);
+	GLState::enable(GL_DEPTH_TEST);
+	GLState::depthFunc(GL_LESS);
+	GLState::depthMask(true);
+	const GLfloat farDepth[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glClearBufferfv(GL_COLOR, 0, farDepth);
+	glClearBufferfv(GL_DEPTH, 0, farDepth);
+	GLState::useProgram(_occluderShader->getHandle());
+}
+
+void HiZCuller::drawOccluder(const Geometry& geometry)
+{
+	std::shared_ptr<Mesh> mesh = geometry.getMesh();
+	if (!mesh->isReady()) return;
+	mesh->setUniforms(_occluderShader.get());
+	_occluderShader->setUniform(MODEL_MATRIX, geometry.getModelMatrix());
+	mesh->draw();
+}
+
+void HiZCuller::endOccluders()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(_viewport[0], _viewport[1], _viewport[2], _viewport[3]);
+	if (!_buildShader.isValid()) return;
+
+	// every level takes the farthest depth of the 2x2 texels of the level before
+	_buildShader.use();
+	for (unsigned int level = 1; level < _levels; level++) {
+		GLuint levelWidth = std::max(1u, _width >> level), levelHeight = std::max(1u, _height >> level);
+		glBindImageTexture(0, _hiZTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(1, _hiZTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		_buildShader.dispatch((levelWidth + BUILD_GROUP_SIZE - 1) / BUILD_GROUP_SIZE, (levelHeight + BUILD_GROUP_SIZE - 1) / BUILD_GROUP_SIZE);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+}
+
+void HiZCuller::test(const glm::mat4& viewProjection)
+{
+	size_t count = _boxes.size() / 2;
+	if (count == 0 || !_testShader.isValid()) return;
+
+	// the buffer is orphaned, the last test may still read it
+	_boxCapacity = std::max(_boxCapacity, count);
+	GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, _boxBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, _boxCapacity * 2 * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * 2 * sizeof(glm::vec4), _boxes.data());
+
+	// more objects than before: all result buffers grow and the tests in flight are dropped
+	if (count > _resultCapacity) {
+		_resultCapacity = count;
+		for (unsigned int i = 0; i < RESULT_BUFFERS; i++) {
+			if (_fences[i] != 0) glDeleteSync(_fences[i]);
+			_fences[i] = 0;
+			GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, _resultBuffers[i]);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, _resultCapacity * sizeof(GLuint), nullptr, GL_STREAM_READ);
+		}
+	}
+	GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// the oldest buffer is reused, its results are dropped if they never arrived
+	unsigned int result = _nextResult;
+	_nextResult = (_nextResult + 1) % RESULT_BUFFERS;
+	if (_fences[result] != 0) {
+		glDeleteSync(_fences[result]);
+		_fences[result] = 0;
+	}
+
+	GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _boxBuffer);
+	GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _resultBuffers[result]);
+	GLState::bindTexture(HI_Z_UNIT, GL_TEXTURE_2D, _hiZTexture);
+	_testShader.setUniform(VIEW_PROJ_MATRIX, viewProjection);
+	_testShader.setUniform(BOX_COUNT, unsigned(count));
+	_testShader.use();
+	_testShader.dispatch(GLuint((count + TEST_GROUP_SIZE - 1) / TEST_GROUP_SIZE));
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	_fences[result] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	_resultCounts[result] = count;
+}
+
+void HiZCuller::readResults()
+{
+	// fences signal in order, so the newest signaled test is the first one found going back from the last
+	for (unsigned int age = 1; age <= RESULT_BUFFERS; age++) {
+		unsigned int result = (_nextResult + RESULT_BUFFERS - age) % RESULT_BUFFERS;
+		if (_fences[result] == 0) continue;
+		GLenum status = glClientWaitSync(_fences[result], 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+
+		_results.resize(_resultCounts[result]);
+		GLState::bindBuffer(GL_COPY_READ_BUFFER, _resultBuffers[result]);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, _results.size() * sizeof(GLuint), _results.data());
+		GLState::bindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		// the older tests are finished as well and never newer than this one
+		for (unsigned int older = age; older <= RESULT_BUFFERS; older++) {
+			unsigned int index = (_nextResult + RESULT_BUFFERS - older) % RESULT_BUFFERS;
+			if (_fences[index] != 0) glDeleteSync(_fences[index]);
+			_fences[index] = 0;
+		}
+		return;
+	}
+}
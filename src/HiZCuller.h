@@ -0,0 +1,108 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include "ComputeShader.h"
+#include "Geometry.h"
+#include "Shader.h"
+
+/*!
+ * Occlusion culling on the GPU with a hierarchical-Z pyramid
+ * Every frame the large occluders are drawn into a small depth target, a compute shader reduces it to a pyramid of
+ * farthest depths and a second one tests the bounding boxes of all objects against it (hiz_test.comp does what
+ * OcclusionBuffer::isVisible does on the CPU). The results are read back a few frames later, once their fence
+ * has signaled, so the CPU never waits for the GPU. An object that is no longer hidden therefore appears one or two
+ * frames late, objects without a result yet are visible.
+ */
+class HiZCuller
+{
+protected:
+	/*!
+	 * Number of result buffers in flight, the GPU may be this many frames behind without a stall
+	 */
+	static const unsigned int RESULT_BUFFERS = 3;
+
+	unsigned int _width, _height, _levels;
+	/*!
+	 * Framebuffer of the occluder pass: level 0 of the pyramid as color, a depth renderbuffer for the depth test
+	 */
+	GLuint _framebuffer, _depthBuffer;
+	/*!
+	 * R32F texture with the full mip chain, every level holds the farthest depth of the 2x2 texels below it
+	 */
+	GLuint _hiZTexture;
+	/*!
+	 * Bounding boxes of all objects as minimum and maximum corner, uploaded before every test
+	 */
+	std::vector<glm::vec4> _boxes;
+	GLuint _boxBuffer;
+	size_t _boxCapacity;
+	/*!
+	 * One visibility flag per object for every test in flight, and the fence that signals its completion
+	 */
+	GLuint _resultBuffers[RESULT_BUFFERS];
+	GLsync _fences[RESULT_BUFFERS];
+	size_t _resultCounts[RESULT_BUFFERS];
+	size_t _resultCapacity;
+	unsigned int _nextResult;
+	/*!
+	 * The newest results that arrived on the CPU
+	 */
+	std::vector<GLuint> _results;
+	GLint _viewport[4];
+
+	std::shared_ptr<Shader> _occluderShader;
+	ComputeShader _buildShader, _testShader;
+
+public:
+	/*!
+	 * Creates the render target and the shaders
+	 * @param width: width of the occluder depth target, a power of two
+	 * @param height: height of the occluder depth target, a power of two
+	 */
+	HiZCuller(unsigned int width = 512, unsigned int height = 256);
+	~HiZCuller();
+
+	HiZCuller(const HiZCuller&) = delete;
+	HiZCuller& operator=(const HiZCuller&) = delete;
+
+	/*!
+	 * Sets the bounding box of an object for the next tests
+	 * @param object: index of the object, the same index is used for isVisible()
+	 * @param min: minimum corner of the box in world space
+	 * @param max: maximum corner of the box in world space
+	 */
+	void setBox(size_t object, const glm::vec3& min, const glm::vec3& max);
+
+	/*!
+	 * Binds and clears the occluder target, the per-frame uniforms have to be set
+	 */
+	void beginOccluders();
+	/*!
+	 * Draws the mesh of an object into the occluder target, only between beginOccluders() and endOccluders()
+	 * @param geometry: the occluder, it should be solid and large on screen
+	 */
+	void drawOccluder(const Geometry& geometry);
+	/*!
+	 * Builds the pyramid and restores the default framebuffer and the viewport
+	 */
+	void endOccluders();
+
+	/*!
+	 * Tests all boxes against the pyramid, the results arrive in a later frame
+	 * @param viewProjection: the view-projection matrix the occluders were drawn with
+	 */
+	void test(const glm::mat4& viewProjection);
+	/*!
+	 * Copies the newest finished results to the CPU, without waiting for the GPU
+	 */
+	void readResults();
+
+	/*!
+	 * @param object: index of the object
+	 * @return if the object was visible in the newest results, true if there are none
+	 */
+	bool isVisible(size_t object) const { return object >= _results.size() || _results[object] != 0; }
+};
@@ -10,9 +10,19 @@
 #include "Camera.h"
 #include "Shader.h"
 #include "Geometry.h"
+#include "MeshRegistry.h"
+#include "RenderQueue.h"
+#include "BVH.h"
+#include "OcclusionBuffer.h"
+#include "HiZCuller.h"
+#include "GPUTimer.h"
+#include "FrameUniforms.h"
+#include "GLState.h"
+#include "AssetLoader.h"
 #include "Material.h"
 #include "Light.h"
 #include "Texture.h"
+#include "TexturePacker.h"
 #include"PxPhysicsAPI.h"
 #include <ft2build.h>
 #include FT_FREETYPE_H 
@@ -20,6 +30,7 @@
 #include <iostream>
 #include "glm/ext.hpp"
 #include "FontCharacter.h"
+#include "Benchmark.h"
 
 // MY includes
 #include <string>
@@ -47,8 +58,8 @@ static std::string FormatDebugOutput(GLenum source, GLenum type, GLuint id, GLen
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-void setPerFrameUniforms(Shader* shader, Camera& camera, DirectionalLight& dirL, PointLight& pointL);
 static long milliseconds_now();
+static bool passesRing(const Geometry& ring, const glm::vec3& p0, const glm::vec3& p1);
 
 /* --------------------------------------------- */
 // Global variables
@@ -77,9 +88,12 @@ static bool _cameraForward = false;
 static bool _cameraBackward = false;
 static int _camera = 2;
 static bool _coutINFO = false;
+static bool _pick = false;
 int INFO_count = 0;
 const int FRAMES_PER_SECOND = 60;
 const int SKIP_TICKS = 1000 / FRAMES_PER_SECOND;
+// occluders smaller than this on screen hide too little to be drawn into the occlusion buffer
+const float OCCLUDER_SCREEN_SIZE = 0.1f;
 
 
 /* --------------------------------------------- */
@@ -90,6 +104,12 @@ using namespace std;
 
 int main(int argc, char** argv)
 {
+	// run the CPU benchmarks instead of the game
+	if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+		runBenchmarks();
+		return EXIT_SUCCESS;
+	}
+
 	/* --------------------------------------------- */
 	// Load settings.ini
 	/* --------------------------------------------- */
@@ -106,6 +126,22 @@ int main(int argc, char** argv)
 	float fov = float(reader.GetReal("camera", "fov", 60.0f));
 	float nearZ = float(reader.GetReal("camera", "near", 0.1f));
 	float farZ = float(reader.GetReal("camera", "far", 100.0f));
+	std::string vertex_layout = reader.Get("geometry", "vertex_layout", "separate");
+	VertexLayout vertexLayout = VertexLayout::SEPARATE;
+	if (vertex_layout == "interleaved") vertexLayout = VertexLayout::INTERLEAVED;
+	else if (vertex_layout == "packed") vertexLayout = VertexLayout::INTERLEAVED_PACKED_NORMALS;
+	else if (vertex_layout == "quantized") vertexLayout = VertexLayout::QUANTIZED;
+	bool instancing = reader.GetBoolean("geometry", "instancing", true);
+	int stress_rings = reader.GetInteger("stress", "rings", 0);
+	bool streaming = reader.GetBoolean("streaming", "enabled", true);
+	int streaming_workers = reader.GetInteger("streaming", "workers", 2);
+	int upload_budget_kb = reader.GetInteger("streaming", "upload_budget_kb", 512);
+	bool pack_textures = reader.GetBoolean("textures", "pack_arrays", true);
+	bool sdf_font = reader.GetBoolean("hud", "sdf_font", true);
+	std::string occlusion_mode = reader.Get("occlusion", "mode", "off");
+	bool cpuOcclusion = occlusion_mode == "cpu";
+	bool gpuOcclusion = occlusion_mode == "gpu";
+	bool depth_prepass = reader.GetBoolean("rendering", "depth_prepass", false);
 
 	/* --------------------------------------------- */
 	// Create context
@@ -159,10 +195,6 @@ int main(int argc, char** argv)
 		// version.
 		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 	}
-	//initializing freetype
-	FontCharacter font;
-	font.initialize();
-
 	/* --------------------------------------------- */
 	// Init framework
 	/* --------------------------------------------- */
@@ -178,8 +210,8 @@ int main(int argc, char** argv)
 
 	// set GL defaults
 	glClearColor(0.5f, 0.5f, 0.5f, 1);
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
+	GLState::enable(GL_DEPTH_TEST);
+	GLState::enable(GL_CULL_FACE);
 
 
 
@@ -188,41 +220,80 @@ int main(int argc, char** argv)
 	/* --------------------------------------------- */
 	{
 		// Load shader(s)
-		std::shared_ptr<Shader> textureShader = std::make_shared<Shader>("texture.vert", "texture.frag");
+		std::shared_ptr<Shader> textureShader = Shader::create("texture.vert", "texture.frag");
+		// positions only, for the depth pre-pass
+		std::shared_ptr<Shader> depthShader = Shader::create("depth.vert", "depth.frag");
 		//std::shared_ptr<Shader> textureShader = std::make_shared<Shader>("HUD.vertex", "HUD.fragment");
-		// Create textures
-		std::shared_ptr<Texture> woodTexture = std::make_shared<Texture>("wood_texture.dds");
-		std::shared_ptr<Texture> brickTexture = std::make_shared<Texture>("bricks_diffuse.dds");
-		std::shared_ptr<Texture> ringTexture = std::make_shared<Texture>("ringtex.dds");
+		// Textures and meshes are loaded in the background and appear when they are uploaded, without streaming they are loaded here
+		std::unique_ptr<AssetLoader> loader(streaming ? new AssetLoader(streaming_workers, size_t(upload_budget_kb) * 1024) : nullptr);
+		// Create textures, textures with the same format, size and mip levels share one array texture
+		TexturePacker textures(pack_textures);
+		textures.add("wood_texture.dds");
+		textures.add("bricks_diffuse.dds");
+		textures.add("ringtex.dds");
+		textures.pack(loader.get());
+		std::cout << textures.getFileCount() << " textures packed into " << textures.getTextureCount() << " texture objects" << std::endl;
+		TextureLayer woodTexture = textures.get("wood_texture.dds");
+		TextureLayer brickTexture = textures.get("bricks_diffuse.dds");
+		TextureLayer ringTexture = textures.get("ringtex.dds");
 
 		// Create materials
-		std::shared_ptr<Material> woodTextureMaterial = std::make_shared<TextureMaterial>(textureShader, glm::vec3(0.1f, 0.7f, 0.1f), 2.0f, woodTexture);
-		std::shared_ptr<Material> brickTextureMaterial = std::make_shared<TextureMaterial>(textureShader, glm::vec3(0.1f, 0.7f, 0.3f), 8.0f, brickTexture);
-		std::shared_ptr<Material> ringTextureMaterial = std::make_shared<TextureMaterial>(textureShader, glm::vec3(0.1f, 0.7f, 0.3f), 1.0, ringTexture);
+		std::shared_ptr<Material> woodTextureMaterial = std::make_shared<TextureMaterial>(textureShader, glm::vec3(0.1f, 0.7f, 0.1f), 2.0f, woodTexture.texture, woodTexture.layer);
+		std::shared_ptr<Material> brickTextureMaterial = std::make_shared<TextureMaterial>(textureShader, glm::vec3(0.1f, 0.7f, 0.3f), 8.0f, brickTexture.texture, brickTexture.layer);
+		std::shared_ptr<Material> ringTextureMaterial = std::make_shared<TextureMaterial>(textureShader, glm::vec3(0.1f, 0.7f, 0.3f), 1.0, ringTexture.texture, ringTexture.layer);
 		// Create geometry
 		 //Geometry cube = Geometry(glm::mat4(1.0f), Geometry::createCubeGeometry(1.5f, 1.5f, 2.5f), woodTextureMaterial);
-		Geometry cylinder = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(-10.0f, 0.0f, -5.0f)), Geometry::createCylinderGeometry(32, 1.3f, 1.0f), brickTextureMaterial);
-		Geometry sphere = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 0.0f, -5.0f)), Geometry::createSphereGeometry(64, 32, 1.0f), brickTextureMaterial);
+		MeshRegistry meshes(loader.get());
+		// procedural meshes halve their segments for every coarser level of detail
+		std::vector<std::shared_ptr<Mesh>> cylinderLODs = meshes.getLODs("cylinder 32 1.3 1.0", vertexLayout, 3, [](unsigned int lod) { return Geometry::createCylinderGeometry(32 >> lod, 1.3f, 1.0f); });
+		Geometry cylinder = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(-10.0f, 0.0f, -5.0f)), cylinderLODs[0], brickTextureMaterial);
+		cylinder.setLODs(cylinderLODs);
+		std::vector<std::shared_ptr<Mesh>> sphereLODs = meshes.getLODs("sphere 64 32 1.0", vertexLayout, 4, [](unsigned int lod) { return Geometry::createSphereGeometry(64 >> lod, 32 >> lod, 1.0f); });
+		Geometry sphere = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 0.0f, -5.0f)), sphereLODs[0], brickTextureMaterial);
+		sphere.setLODs(sphereLODs);
 		// create userShip as cube
-		Geometry cube = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.0f, 0.0f)), Geometry::createOBJGeometry("assets/objects/testship.obj"), woodTextureMaterial);
-		// create rings
+		Geometry cube = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.0f, 0.0f)), meshes.load("assets/objects/testship.obj", vertexLayout), woodTextureMaterial);
+		// create rings, all rings share one mesh and its simplified levels of detail
+		std::vector<std::shared_ptr<Mesh>> ringLODs = meshes.loadLODs("assets/objects/ring.obj", vertexLayout, 3);
 		// ring1
-		Geometry ring1 = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f)), Geometry::createOBJGeometry("assets/objects/ring.obj"), ringTextureMaterial);
+		Geometry ring1 = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f)), ringLODs[0], ringTextureMaterial);
+		ring1.setLODs(ringLODs);
 		ring1.transform(glm::rotate(1.0f, glm::vec3(0.0f, 1.0f, 0.0f)));
 		ring1.transform(glm::translate(glm::mat4(1.0f), glm::vec3(20.0f, 0.0f, -35.0f)));
 		// ring2
-		Geometry ring2 = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f)), Geometry::createOBJGeometry("assets/objects/ring.obj"), ringTextureMaterial);
+		Geometry ring2 = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f)), ringLODs[0], ringTextureMaterial);
+		ring2.setLODs(ringLODs);
 		ring2.transform(glm::rotate(4.0f, glm::vec3(2.0f, 1.0f, 0.0f)));
 		ring2.transform(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 20.0f, -60.0f)));
 		// ring3
-		Geometry ring3 = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f)), Geometry::createOBJGeometry("assets/objects/ring.obj"), ringTextureMaterial);
+		Geometry ring3 = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f)), ringLODs[0], ringTextureMaterial);
+		ring3.setLODs(ringLODs);
 		ring3.transform(glm::rotate(2.0f, glm::vec3(0.0f, 1.0f, 1.0f)));
 		ring3.transform(glm::translate(glm::mat4(1.0f), glm::vec3(-15.0f, 0.0f, -40.0f)));
-		// create moving spheres
+		// stress scene: additional rings along a spiral track
+		std::vector<Geometry> stressRings;
+		for (int i = 0; i < stress_rings; i++) {
+			float angle = float(i) * 0.5f;
+			glm::vec3 position = glm::vec3(30.0f * glm::cos(angle), 30.0f * glm::sin(angle), -80.0f - float(i) * 2.0f);
+			stressRings.push_back(Geometry(glm::translate(glm::mat4(1.0f), position), ringLODs[0], ringTextureMaterial));
+			stressRings.back().setLODs(ringLODs);
+		}
+		// create moving spheres, both share one mesh
+		std::vector<std::shared_ptr<Mesh>> obstacleLODs = meshes.getLODs("sphere 30 15 1.0", vertexLayout, 3, [](unsigned int lod) {
+			return lod == 0 ? Geometry::createSphereGeometry(30, 15, 1.0f) : Geometry::createSphereGeometry(32 >> lod, 16 >> lod, 1.0f);
+		});
 		// sphere1
-		Geometry sphere1 = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(-10.0f, -10.0f, -25.0f)), Geometry::createSphereGeometry(30, 15, 1.0f), brickTextureMaterial);
+		Geometry sphere1 = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(-10.0f, -10.0f, -25.0f)), obstacleLODs[0], brickTextureMaterial);
+		sphere1.setLODs(obstacleLODs);
 		// sphere2
-		Geometry sphere2 = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 10.0f, -25.0f)), Geometry::createSphereGeometry(30, 15, 1.0f), woodTextureMaterial);
+		Geometry sphere2 = Geometry(glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 10.0f, -25.0f)), obstacleLODs[0], woodTextureMaterial);
+		sphere2.setLODs(obstacleLODs);
+		// solid objects that hide what is behind them, the rings have holes
+		// the CPU rasterizes low polygon shapes with their vertices on the surface, so they never cover more than the object
+		std::vector<Geometry*> occluders = { &cylinder, &sphere, &sphere1, &sphere2 };
+		GeometryData cylinderOccluder = Geometry::createCylinderGeometry(16, 1.3f, 1.0f);
+		GeometryData sphereOccluder = Geometry::createSphereGeometry(16, 8, 1.0f);
+		std::vector<const GeometryData*> occluderShapes = { &cylinderOccluder, &sphereOccluder, &sphereOccluder, &sphereOccluder };
 		
 		
 		
@@ -233,8 +304,30 @@ int main(int argc, char** argv)
 		DirectionalLight dirL(glm::vec3(0.8f), glm::vec3(0.0f, -1.0f, -1.0f));
 		PointLight pointL(glm::vec3(1.0f), glm::vec3(0.0f), glm::vec3(1.0f, 0.4f, 0.1f));
 		PointLight pointL2(glm::vec3(-1.0f), glm::vec3(0.0f), glm::vec3(1.0f, 0.4f, 0.1f));
-
-		//Initialize text overlay
+		std::vector<DirectionalLight> dirLights = { dirL };
+		std::vector<PointLight> pointLights = { pointL };
+		// camera and lights for all shaders, updated once per frame
+		FrameUniforms frameUniforms;
+
+		//Initialize text overlay, all HUD text of a frame is drawn with one draw call
+		FontCharacter font;
+		font.initialize(sdf_font);
+		font.setScreenSize(window_width, window_height);
+		font.setOutline(2.0f, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		font.setShadow(glm::vec2(3.0f, 3.0f), glm::vec4(0.0f, 0.0f, 0.0f, 0.5f));
+		std::shared_ptr<Shader> hudShader = Shader::create("HUD.vertex", sdf_font ? "HUD_SDF.fragment" : "HUD.fragment");
+		TextLabel* timeLabel = font.createLabel(16);
+		timeLabel->setPosition(glm::vec2(20.0f, float(window_height) - 40.0f));
+		timeLabel->setScale(0.6f);
+		TextLabel* ringLabel = font.createLabel(16);
+		ringLabel->setPosition(glm::vec2(20.0f, float(window_height) - 80.0f));
+		ringLabel->setScale(0.6f);
+		TextLabel* speedLabel = font.createLabel(16);
+		speedLabel->setPosition(glm::vec2(20.0f, 20.0f));
+		speedLabel->setScale(0.6f);
+		speedLabel->setColor(glm::vec4(1.0f, 0.8f, 0.2f, 1.0f));
+		char hudText[32];
+		size_t textBytesFPS = 0;
 
 		// Render loop
 		float t = float(glfwGetTime());
@@ -242,7 +335,52 @@ int main(int argc, char** argv)
 		float t_sum = 0.0f;
 		double mouse_x, mouse_y;
 		int FPS = 0;
+		float cpuTimeSum = 0.0f;
+		// texture counters once all assets are loaded, nothing may be read or uploaded afterwards
+		bool assetsLoaded = false;
+		TextureStats textureStatsLoaded = Texture::getStats();
 		float lastTimeFPS = float(glfwGetTime());
+		size_t heapAllocationsFPS = getHeapAllocationCount();
+		GLStateStats glStateFPS = GLState::getStats();
+		RenderQueue renderQueue(instancing);
+		// static objects are in one tree that is built again until all meshes are loaded, the rings come first
+		std::vector<Geometry*> staticObjects = { &ring1, &ring2, &ring3 };
+		for (Geometry& ring : stressRings) staticObjects.push_back(&ring);
+		const size_t ringCount = staticObjects.size();
+		staticObjects.push_back(&cylinder);
+		staticObjects.push_back(&sphere);
+		// moving objects are in a second tree that is refitted every frame for picking,
+		// their bounding spheres change every frame anyway and are culled in one pass over a flat array
+		std::vector<Geometry*> movingObjects = { &cube, &sphere1, &sphere2 };
+		BVH staticTree, movingTree;
+		for (Geometry* object : staticObjects) {
+			Bounds bounds = object->getWorldBounds();
+			staticTree.add(bounds.min, bounds.max);
+		}
+		for (Geometry* object : movingObjects) {
+			Bounds bounds = object->getWorldBounds();
+			movingTree.add(bounds.min, bounds.max);
+		}
+		movingTree.build();
+		SphereCuller movingSpheres;
+		movingSpheres.reserve(movingObjects.size());
+		std::vector<unsigned char> movingVisibility;
+		bool staticTreeDirty = true;
+		std::vector<uint32_t> visibleStatic, visibleMoving, ringCandidates;
+		visibleStatic.reserve(staticObjects.size());
+		visibleMoving.reserve(movingObjects.size());
+		ringCandidates.reserve(ringCount);
+		int ringsPassed = 0;
+		size_t culledFPS = 0;
+		size_t trianglesFPS = 0;
+		// occlusion culling against the large occluders, on the GPU the results arrive one or two frames later
+		std::unique_ptr<HiZCuller> hiZCuller(gpuOcclusion ? new HiZCuller() : nullptr);
+		OcclusionBuffer occlusionBuffer;
+		std::vector<size_t> largeOccluders;
+		largeOccluders.reserve(occluders.size());
+		size_t occludedFPS = 0;
+		// GPU time of the depth pre-pass and of the shading pass of the scene
+		GPUTimer depthPassTimer, shadingPassTimer;
 
 		// targetFpsTime = 1000/60 -> 60 FPS
 		float targetFpsTime = 1000 / refresh_rate;
@@ -257,12 +395,17 @@ int main(int argc, char** argv)
 
 		while (!glfwWindowShouldClose(window)) {
 
+			float frameStart = float(glfwGetTime());
+
 			// Clear backbuffer
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 			// Poll events
 			glfwPollEvents();
 
+			// Upload streamed assets
+			if (loader != nullptr) loader->update();
+
 			// print cameraPosition to console
 			glm::vec3 cameraPositionOLD = camera.getPosition();
 			// print cubeMatrix to console
@@ -500,6 +643,55 @@ int main(int argc, char** argv)
 				camera.updates(int(mouse_x), int(mouse_y), _zoom, _dragging, _strafing);
 			}
 
+			// Update the trees, the static tree only changes while meshes are streamed in
+			if (staticTreeDirty) {
+				for (uint32_t i = 0; i < staticObjects.size(); i++) {
+					Bounds bounds = staticObjects[i]->getWorldBounds();
+					staticTree.update(i, bounds.min, bounds.max);
+					if (hiZCuller) hiZCuller->setBox(i, bounds.min, bounds.max);
+				}
+				staticTree.build();
+				staticTreeDirty = !assetsLoaded;
+			}
+			movingSpheres.clear();
+			for (uint32_t i = 0; i < movingObjects.size(); i++) {
+				Bounds bounds = movingObjects[i]->getWorldBounds();
+				movingTree.update(i, bounds.min, bounds.max);
+				movingSpheres.add(movingObjects[i]->getBoundingSphere());
+				if (hiZCuller) hiZCuller->setBox(staticObjects.size() + i, bounds.min, bounds.max);
+			}
+			if (movingTree.refit()) movingTree.build();
+
+			// Count the rings the ship flew through this frame
+			glm::vec3 shipFrom = glm::vec3(cubeMatrixOLD[3]);
+			glm::vec3 shipTo = glm::vec3(cube.getModelMatrix()[3]);
+			if (shipFrom != shipTo) {
+				ringCandidates.clear();
+				staticTree.querySegment(shipFrom, shipTo, ringCandidates);
+				for (uint32_t object : ringCandidates) {
+					if (object < ringCount && passesRing(*staticObjects[object], shipFrom, shipTo)) ringsPassed++;
+				}
+			}
+
+			// Pick the object under the mouse cursor
+			if (_pick) {
+				_pick = false;
+				glm::mat4 inverseViewProjection = glm::inverse(camera.getViewProjectionMatrix());
+				glm::vec2 ndc = glm::vec2(2.0f * float(mouse_x) / float(window_width) - 1.0f, 1.0f - 2.0f * float(mouse_y) / float(window_height));
+				glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+				glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+				glm::vec3 rayOrigin = glm::vec3(nearPoint) / nearPoint.w;
+				glm::vec3 rayDirection = glm::vec3(farPoint) / farPoint.w - rayOrigin;
+				float distance = 1.0f;
+				int staticHit = staticTree.raycast(rayOrigin, rayDirection, distance);
+				int movingHit = movingTree.raycast(rayOrigin, rayDirection, distance);
+				Geometry* picked = movingHit >= 0 ? movingObjects[movingHit] : staticHit >= 0 ? staticObjects[staticHit] : nullptr;
+				if (picked != nullptr) {
+					cout << "picked object at " << glm::to_string(glm::vec3(picked->getModelMatrix()[3]))
+						<< ", distance " << distance * glm::length(rayDirection) << "\n\n";
+				}
+			}
+
 
 			//my Camera Update Stuff
 			/*glm::mat4 cubeMatrixNEW = cube.getModelMatrix();
@@ -511,20 +703,122 @@ int main(int argc, char** argv)
 			//camera.myPositionUpdate(newVector);
 
 			// Set per-frame uniforms
-			setPerFrameUniforms(textureShader.get(), camera, dirL, pointL);
-
-			// Render
-			cube.draw();
-			cylinder.draw();
-			sphere.draw();
-			ring1.draw();
-			ring2.draw();
-			ring3.draw();
-			sphere1.draw();
-			sphere2.draw();
+			frameUniforms.update(camera, dirLights, pointLights);
+
+			// Cull objects behind the camera or beyond the far plane
+			Frustum frustum = camera.getFrustum();
+			visibleStatic.clear();
+			visibleMoving.clear();
+			staticTree.queryFrustum(frustum, visibleStatic);
+			movingSpheres.cull(frustum, movingVisibility);
+			for (uint32_t i = 0; i < movingObjects.size(); i++) {
+				if (movingVisibility[i]) visibleMoving.push_back(i);
+			}
+			culledFPS += staticObjects.size() + movingObjects.size() - visibleStatic.size() - visibleMoving.size();
+
+			// Cull objects hidden behind the occluders that are large on screen
+			if (cpuOcclusion || gpuOcclusion) {
+				largeOccluders.clear();
+				for (size_t i = 0; i < occluders.size(); i++) {
+					glm::vec4 boundingSphere = occluders[i]->getBoundingSphere();
+					if (frustum.containsSphere(glm::vec3(boundingSphere), boundingSphere.w)
+						&& camera.getScreenSize(glm::vec3(boundingSphere), boundingSphere.w) >= OCCLUDER_SCREEN_SIZE) {
+						largeOccluders.push_back(i);
+					}
+				}
+				glm::mat4 viewProjection = camera.getViewProjectionMatrix();
+				size_t visibleCount = visibleStatic.size() + visibleMoving.size();
+				if (cpuOcclusion) {
+					occlusionBuffer.clear(viewProjection);
+					for (size_t i : largeOccluders) occlusionBuffer.rasterize(occluderShapes[i]->positions, occluderShapes[i]->indices, occluders[i]->getModelMatrix());
+					occlusionBuffer.buildHiZ();
+					visibleStatic.erase(std::remove_if(visibleStatic.begin(), visibleStatic.end(), [&](uint32_t object) {
+						return !occlusionBuffer.isVisible(staticTree.getMin(object), staticTree.getMax(object));
+					}), visibleStatic.end());
+					visibleMoving.erase(std::remove_if(visibleMoving.begin(), visibleMoving.end(), [&](uint32_t object) {
+						return !occlusionBuffer.isVisible(movingTree.getMin(object), movingTree.getMax(object));
+					}), visibleMoving.end());
+				}
+				else {
+					// results of an earlier frame decide this frame, the test of this frame runs while the scene is drawn
+					hiZCuller->readResults();
+					visibleStatic.erase(std::remove_if(visibleStatic.begin(), visibleStatic.end(), [&](uint32_t object) {
+						return !hiZCuller->isVisible(object);
+					}), visibleStatic.end());
+					visibleMoving.erase(std::remove_if(visibleMoving.begin(), visibleMoving.end(), [&](uint32_t object) {
+						return !hiZCuller->isVisible(staticObjects.size() + object);
+					}), visibleMoving.end());
+					hiZCuller->beginOccluders();
+					for (size_t i : largeOccluders) hiZCuller->drawOccluder(*occluders[i]);
+					hiZCuller->endOccluders();
+					GLState::polygonMode(_wireframe ? GL_LINE : GL_FILL);
+					hiZCuller->test(viewProjection);
+				}
+				occludedFPS += visibleCount - visibleStatic.size() - visibleMoving.size();
+			}
+
+			// Select the level of detail of the visible objects by their size on screen
+			for (uint32_t object : visibleStatic) {
+				glm::vec4 boundingSphere = staticObjects[object]->getBoundingSphere();
+				staticObjects[object]->selectLOD(camera.getScreenSize(glm::vec3(boundingSphere), boundingSphere.w));
+				trianglesFPS += staticObjects[object]->getMesh()->getElementCount() / 3;
+			}
+			for (uint32_t object : visibleMoving) {
+				glm::vec4 boundingSphere = movingObjects[object]->getBoundingSphere();
+				movingObjects[object]->selectLOD(camera.getScreenSize(glm::vec3(boundingSphere), boundingSphere.w));
+				trianglesFPS += movingObjects[object]->getMesh()->getElementCount() / 3;
+			}
+
+			// Render, sorted by state
+			renderQueue.begin(camera.getPosition(), farZ);
+			for (uint32_t object : visibleStatic) renderQueue.submit(*staticObjects[object]);
+			for (uint32_t object : visibleMoving) renderQueue.submit(*movingObjects[object]);
+			renderQueue.sort();
+			renderQueue.record();
+			if (depth_prepass) {
+				// lay down the depth first, the shading pass then only shades the visible fragment of every pixel
+				depthPassTimer.begin();
+				GLState::depthFunc(GL_LESS);
+				GLState::depthMask(true);
+				GLState::colorMask(false);
+				renderQueue.executeDepth(depthShader.get());
+				GLState::colorMask(true);
+				depthPassTimer.end();
+				GLState::depthFunc(GL_EQUAL);
+				GLState::depthMask(false);
+			}
+			shadingPassTimer.begin();
+			renderQueue.execute();
+			shadingPassTimer.end();
+			// glClear of the next frame needs depth writes
+			GLState::depthFunc(GL_LESS);
+			GLState::depthMask(true);
 			// *******userShip is rendered as cube at the moment*******
 			//userShip.draw();
 
+			// HUD, the labels are only uploaded when their text changes
+			snprintf(hudText, sizeof(hudText), "Time %.1f", std::max(countDown, 0.0f));
+			timeLabel->setText(hudText);
+			snprintf(hudText, sizeof(hudText), "Rings %d", ringsPassed);
+			ringLabel->setText(hudText);
+			snprintf(hudText, sizeof(hudText), "Speed %.1f", dt > 0.0f ? glm::length(glm::vec3(cube.getModelMatrix()[3] - cubeMatrixOLD[3])) / dt : 0.0f);
+			speedLabel->setText(hudText);
+			font.flush(hudShader);
+			textBytesFPS += font.getStats().uploadedBytes;
+
+			cpuTimeSum += float(glfwGetTime()) - frameStart;
+
+			if (!assetsLoaded) {
+				assetsLoaded = loader == nullptr || loader->isIdle();
+				textureStatsLoaded = Texture::getStats();
+			}
+			else if (Texture::getStats().fileReads != textureStatsLoaded.fileReads || Texture::getStats().uploads != textureStatsLoaded.uploads) {
+				std::cout << "ERROR: Textures were read or uploaded after loading ("
+					<< Texture::getStats().fileReads - textureStatsLoaded.fileReads << " file reads, "
+					<< Texture::getStats().uploads - textureStatsLoaded.uploads << " uploads)" << std::endl;
+				textureStatsLoaded = Texture::getStats();
+			}
+
 			// Swap buffers
 			glfwSwapBuffers(window);
 
@@ -539,15 +833,64 @@ int main(int argc, char** argv)
 			if (currentTimeFPS - lastTimeFPS >= 1.0)
 			{
 				// print FPS to console
+				size_t heapAllocations = getHeapAllocationCount() - heapAllocationsFPS;
 				float frameTime = 1000 / float(FPS);
 				cout << "***** FPS *****\n\n";
 				cout << frameTime << std::endl;
 				cout << "ms/frame\n\n";
 				cout << FPS << std::endl;
 				cout << "FPS\n\n";
+				cout << 1000 * cpuTimeSum / float(FPS) << std::endl;
+				cout << "ms/frame CPU\n\n";
+				if (depth_prepass) {
+					cout << depthPassTimer.getAverage() << std::endl;
+					cout << "ms/frame GPU depth pre-pass\n\n";
+				}
+				cout << shadingPassTimer.getAverage() << std::endl;
+				cout << "ms/frame GPU shading pass\n\n";
+				const RenderQueueStats& renderStats = renderQueue.getStats();
+				cout << renderStats.drawCalls << std::endl;
+				cout << "draw calls\n\n";
+				cout << renderStats.programChanges << " program changes, " << renderStats.materialChanges << " material changes, "
+					<< renderStats.textureBinds << " texture binds, " << renderStats.meshBinds << " mesh binds for "
+					<< renderStats.objects << " objects\n\n";
+				cout << float(culledFPS) / float(FPS) << " of " << staticObjects.size() + movingObjects.size() << std::endl;
+				cout << "objects culled/frame\n\n";
+				if (cpuOcclusion || gpuOcclusion) {
+					cout << float(occludedFPS) / float(FPS) << std::endl;
+					cout << "objects occluded/frame (" << (cpuOcclusion ? "CPU" : "GPU") << ")\n\n";
+				}
+				cout << float(trianglesFPS) / float(FPS) << std::endl;
+				cout << "triangles/frame after level of detail selection\n\n";
+				cout << font.getStats().drawCalls << " text draw calls for " << font.getStats().glyphs << " glyphs, "
+					<< float(textBytesFPS) / float(FPS) << " bytes uploaded for text/frame\n\n";
+				cout << float(heapAllocations) / float(FPS) << std::endl;
+				cout << "heap allocations/frame\n\n";
+				const GLStateStats& glState = GLState::getStats();
+				cout << float(glState.issued - glStateFPS.issued) / float(FPS) << " issued, "
+					<< float(glState.filtered - glStateFPS.filtered) / float(FPS) << " filtered\n";
+				cout << "GL state calls/frame\n\n";
+				if (loader != nullptr) {
+					AssetLoaderStats loaderStats = loader->getStats();
+					if (!assetsLoaded) {
+						cout << loaderStats.pendingLoads << " loading, " << loaderStats.pendingUploads << " uploading, "
+							<< loaderStats.uploadedBytes / 1024 << " KB uploaded last frame\n";
+					}
+					cout << loaderStats.completed << " assets streamed, latency "
+						<< loaderStats.averageLatency * 1000.0 << " ms average, " << loaderStats.maxLatency * 1000.0 << " ms max\n\n";
+				}
 				cout << "***************\n\n";
 				FPS = 0;
+				cpuTimeSum = 0.0f;
 				lastTimeFPS += 1.0f;
+				heapAllocationsFPS = getHeapAllocationCount();
+				glStateFPS = GLState::getStats();
+				textBytesFPS = 0;
+				culledFPS = 0;
+				trianglesFPS = 0;
+				occludedFPS = 0;
+				depthPassTimer.reset();
+				shadingPassTimer.reset();
 			}
 
 			countDown = countDown - dt;
@@ -606,24 +949,14 @@ int main(int argc, char** argv)
 //}
 
 
-void setPerFrameUniforms(Shader* shader, Camera& camera, DirectionalLight& dirL, PointLight& pointL)
-{
-	shader->use();
-	shader->setUniform("viewProjMatrix", camera.getViewProjectionMatrix());
-	shader->setUniform("camera_world", camera.getPosition());
-
-	shader->setUniform("dirL.color", dirL.color);
-	shader->setUniform("dirL.direction", dirL.direction);
-	shader->setUniform("pointL.color", pointL.color);
-	shader->setUniform("pointL.position", pointL.position);
-	shader->setUniform("pointL.attenuation", pointL.attenuation);
-}
 
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
 	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
 		_dragging = !_dragging;
+	} else if (button == GLFW_MOUSE_BUTTON_MIDDLE && action == GLFW_PRESS) {
+		_pick = true;
 	} else if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
 		_strafing = true;
 	} else if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE) {
@@ -653,13 +986,12 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		case GLFW_KEY_F1:
 			if (action == GLFW_RELEASE) return;
 			_wireframe = !_wireframe;
-			glPolygonMode(GL_FRONT_AND_BACK, _wireframe ? GL_LINE : GL_FILL);
+			GLState::polygonMode(_wireframe ? GL_LINE : GL_FILL);
 			break;
 		case GLFW_KEY_F2:
 			if (action == GLFW_RELEASE) return;
 			_culling = !_culling;
-			if (_culling) glEnable(GL_CULL_FACE);
-			else glDisable(GL_CULL_FACE);
+			GLState::setEnabled(GL_CULL_FACE, _culling);
 			break;
 		case GLFW_KEY_SPACE:
 			if (action == GLFW_RELEASE) _accalerate = false;
@@ -861,3 +1193,21 @@ static long milliseconds_now() {
 	}
 }
 
+/*!
+ * Tests if a line segment flies through the opening of a ring
+ * The ring mesh lies in its local yz plane around the origin.
+ * @param ring: the ring
+ * @param p0: start of the segment in world space
+ * @param p1: end of the segment in world space
+ * @return if the segment crosses the ring plane inside the opening
+ */
+static bool passesRing(const Geometry& ring, const glm::vec3& p0, const glm::vec3& p1)
+{
+	const float innerRadius = 6.9f;
+	glm::mat4 toLocal = glm::inverse(ring.getModelMatrix());
+	glm::vec3 a = glm::vec3(toLocal * glm::vec4(p0, 1.0f));
+	glm::vec3 b = glm::vec3(toLocal * glm::vec4(p1, 1.0f));
+	if ((a.x < 0.0f) == (b.x < 0.0f)) return false;
+	glm::vec3 hit = a + (b - a) * (a.x / (a.x - b.x));
+	return hit.y * hit.y + hit.z * hit.z < innerRadius * innerRadius;
+}
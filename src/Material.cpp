@@ -5,6 +5,16 @@
 */
 #include "Material.h"
 
+/* --------------------------------------------- */
+// Uniforms
+/* --------------------------------------------- */
+
+static const UniformId ILLUMINATION("illumination");
+static const UniformId SPECULAR_ALPHA("specularAlpha");
+static const UniformId DIFFUSE_TEXTURE("diffuseTexture");
+static const UniformId DIFFUSE_TEXTURE_ARRAY("diffuseTextureArray");
+static const UniformId DIFFUSE_LAYER("diffuseLayer");
+
 /* --------------------------------------------- */
 // Base material
 /* --------------------------------------------- */
@@ -25,29 +35,36 @@ Shader* Material::getShader()
 
 void Material::setUniforms()
 {
-	_shader->setUniform("illumination", _materialCoefficients);
-	_shader->setUniform("specularAlpha", _alpha);
+	_shader->setUniform(ILLUMINATION, _materialCoefficients);
+	_shader->setUniform(SPECULAR_ALPHA, _alpha);
 }
 
-TextureMaterial::TextureMaterial(std::shared_ptr<Shader> shader, glm::vec3 materialCoefficients, float specularCoefficient, const char* file)
-	: Material(shader, materialCoefficients, specularCoefficient), _file(file)
+/* --------------------------------------------- */
+// Texture material
+/* --------------------------------------------- */
+
+TextureMaterial::TextureMaterial(std::shared_ptr<Shader> shader, glm::vec3 materialCoefficients, float specularCoefficient, std::shared_ptr<Texture> diffuseTexture, int diffuseLayer)
+	: Material(shader, materialCoefficients, specularCoefficient), _diffuseTexture(diffuseTexture), _diffuseLayer(diffuseLayer)
+{
+}
+
+TextureMaterial::~TextureMaterial()
 {
-	glGenTextures(1, &_handle);
 }
 
 void TextureMaterial::setUniforms()
 {
 	Material::setUniforms();
-	glBindTexture(GL_TEXTURE_2D, _handle);
-	DDSImage data = loadDDS(_file);
-	glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, data.height, data.width, 0, data.size, data.image);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glActiveTexture(GL_TEXTURE0 + 0);
-	_shader->setUniform("diffuseTexture", 0);
+
+	// 2D textures use unit 0, array textures unit 1, so the two sampler types never share a unit
+	_shader->setUniform(DIFFUSE_TEXTURE, 0);
+	_shader->setUniform(DIFFUSE_TEXTURE_ARRAY, 1);
+	// placeholders of streamed arrays are 2D textures
+	_shader->setUniform(DIFFUSE_LAYER, _diffuseTexture->getTarget() == GL_TEXTURE_2D_ARRAY ? _diffuseLayer : -1);
 }
-TextureMaterial::~TextureMaterial()
+
+void TextureMaterial::bindTextures()
 {
-}
\ No newline at end of file
+	// the texture was uploaded once on creation, only bind it
+	_diffuseTexture->bind(_diffuseTexture->getTarget() == GL_TEXTURE_2D_ARRAY ? 1 : 0);
+}
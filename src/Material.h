@@ -52,6 +52,16 @@ public:
 	 * Sets this material's parameters as uniforms in the shader
 	 */
 	virtual void setUniforms();
+
+	/*!
+	 * Binds the textures of this material to their texture units
+	 */
+	virtual void bindTextures() {}
+
+	/*!
+	 * @return the texture this material binds (nullptr if it has none)
+	 */
+	virtual const Texture* getTexture() const { return nullptr; }
 };
 
 
@@ -65,6 +75,10 @@ protected:
 	 * The diffuse texture of this material
 	 */
 	std::shared_ptr<Texture> _diffuseTexture;
+	/*!
+	 * The layer of the diffuse texture if it is an array texture
+	 */
+	int _diffuseLayer;
 
 public:
 	/*!
@@ -73,8 +87,9 @@ public:
 	 * @param materialCoefficients: The material's coefficients (x = ambient, y = diffuse, z = specular)
 	 * @param alpha: Alpha value, i.e. the shininess constant
 	 * @param diffuseTexture: The diffuse texture of this material
+	 * @param diffuseLayer: The layer to sample if the diffuse texture is an array texture
 	 */
-	TextureMaterial(std::shared_ptr<Shader> shader, glm::vec3 materialCoefficients, float alpha, std::shared_ptr<Texture> diffuseTexture);
+	TextureMaterial(std::shared_ptr<Shader> shader, glm::vec3 materialCoefficients, float alpha, std::shared_ptr<Texture> diffuseTexture, int diffuseLayer = 0);
 	
 	virtual ~TextureMaterial();
 
@@ -82,4 +97,14 @@ public:
 	 * Set's this material's parameters as uniforms in the shader
 	 */
 	virtual void setUniforms();
+
+	/*!
+	 * Binds the diffuse texture, 2D textures to unit 0 and array textures to unit 1
+	 */
+	virtual void bindTextures();
+
+	/*!
+	 * @return the diffuse texture
+	 */
+	virtual const Texture* getTexture() const { return _diffuseTexture.get(); }
 };
@@ -0,0 +1,279 @@
+#include "Mesh.h"
+#include <cstddef>
+#include "GLState.h"
+#include "MeshCache.h"
+
+/* --------------------------------------------- */
+// Helpers
+/* --------------------------------------------- */
+
+static const UniformId QUANTIZED("quantized");
+static const UniformId POSITION_OFFSET("positionOffset");
+static const UniformId POSITION_SCALE("positionScale");
+
+/*!
+ * Binds positions to location 0, normals to location 1 and UVs to location 2 of the bound vertex buffer
+ * @param layout: how the vertices are stored
+ * @param vertexCount: number of vertices, needed for the offsets of the SEPARATE layout
+ */
+static void setVertexAttributes(VertexLayout layout, size_t vertexCount)
+{
+	if (layout == VertexLayout::SEPARATE) {
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)(vertexCount * sizeof(glm::vec3)));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (void*)(2 * vertexCount * sizeof(glm::vec3)));
+	}
+	else if (layout == VertexLayout::INTERLEAVED) {
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(InterleavedVertex), (void*)offsetof(InterleavedVertex, position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(InterleavedVertex), (void*)offsetof(InterleavedVertex, normal));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(InterleavedVertex), (void*)offsetof(InterleavedVertex, uv));
+	}
+	else if (layout == VertexLayout::INTERLEAVED_PACKED_NORMALS) {
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PackedNormalVertex), (void*)offsetof(PackedNormalVertex, position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedNormalVertex), (void*)offsetof(PackedNormalVertex, normal));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(PackedNormalVertex), (void*)offsetof(PackedNormalVertex, uv));
+	}
+	else {
+		// compressed attributes, the vertex shader decodes them
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, normal));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, uv));
+	}
+}
+
+/*!
+ * Appends the bytes of a vector to a buffer
+ */
+template<typename T>
+static void appendBytes(std::vector<char>& buffer, const std::vector<T>& elements)
+{
+	const char* bytes = reinterpret_cast<const char*>(elements.data());
+	buffer.insert(buffer.end(), bytes, bytes + elements.size() * sizeof(T));
+}
+
+/*!
+ * Binding point of the per-instance buffer, the vertex attributes use the binding points 0-2
+ */
+static const GLuint INSTANCE_BINDING = 3;
+
+/*!
+ * Sets up the per-instance attributes (model matrix at locations 3-6, normal matrix at locations 7-9)
+ * They stay disabled until an instanced draw binds a buffer to them.
+ */
+static void setInstanceAttributes()
+{
+	for (GLuint column = 0; column < 4; column++) {
+		glVertexAttribFormat(3 + column, 4, GL_FLOAT, GL_FALSE, GLuint(offsetof(InstanceData, modelMatrix) + column * sizeof(glm::vec4)));
+		glVertexAttribBinding(3 + column, INSTANCE_BINDING);
+	}
+	for (GLuint column = 0; column < 3; column++) {
+		glVertexAttribFormat(7 + column, 3, GL_FLOAT, GL_FALSE, GLuint(offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec3)));
+		glVertexAttribBinding(7 + column, INSTANCE_BINDING);
+	}
+	glVertexBindingDivisor(INSTANCE_BINDING, 1);
+}
+
+/* --------------------------------------------- */
+// Mesh data
+/* --------------------------------------------- */
+
+const char* MeshData::vertexData() const
+{
+	return cacheFile != nullptr ? static_cast<const char*>(cacheFile->vertexData()) : vertices.data();
+}
+
+size_t MeshData::vertexDataSize() const
+{
+	return cacheFile != nullptr ? cacheFile->vertexDataSize() : vertices.size();
+}
+
+const char* MeshData::indexData() const
+{
+	return cacheFile != nullptr ? static_cast<const char*>(cacheFile->indexData()) : indices.data();
+}
+
+size_t MeshData::indexDataSize() const
+{
+	return cacheFile != nullptr ? cacheFile->indexDataSize() : indices.size();
+}
+
+/* --------------------------------------------- */
+// Mesh
+/* --------------------------------------------- */
+
+Mesh::Mesh()
+	: _vao(0), _vboVertices(0), _vboIndices(0), _elements(0), _indexType(GL_UNSIGNED_INT),
+	_quantized(false), _positionOffset(0.0f), _positionScale(1.0f), _bounds(Bounds::fromBox(glm::vec3(0.0f), glm::vec3(0.0f))), _ready(false)
+{
+}
+
+Mesh::Mesh(const GeometryData& data)
+	: Mesh()
+{
+	allocate(prepare(data), true);
+}
+
+Mesh::Mesh(const MeshCacheFile& file)
+	: Mesh()
+{
+	allocate(prepare(file), true);
+}
+
+Mesh::~Mesh()
+{
+	GLState::deleteBuffers(1, &_vboVertices);
+	GLState::deleteBuffers(1, &_vboIndices);
+	GLState::deleteVertexArrays(1, &_vao);
+}
+
+MeshData Mesh::prepare(const GeometryData& data)
+{
+	MeshData result;
+	result.layout = data.layout;
+	result.vertexCount = data.positions.size();
+	result.elements = unsigned(data.indices.size());
+	result.indexType = data.hasShortIndices() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	result.positionOffset = glm::vec3(0.0f);
+	result.positionScale = glm::vec3(1.0f);
+	result.bounds = data.bounds.isValid() ? data.bounds : Bounds::fromPoints(data.positions);
+	result.cacheFile = nullptr;
+
+	if (data.layout == VertexLayout::SEPARATE) {
+		// one array per attribute, one after the other
+		std::vector<glm::vec3> normals(data.normals);
+		std::vector<glm::vec2> UVs(data.UVs);
+		normals.resize(result.vertexCount, glm::vec3(0.0f));
+		UVs.resize(result.vertexCount, glm::vec2(0.0f));
+		appendBytes(result.vertices, data.positions);
+		appendBytes(result.vertices, normals);
+		appendBytes(result.vertices, UVs);
+	}
+	else if (data.layout == VertexLayout::INTERLEAVED) {
+		appendBytes(result.vertices, data.interleave());
+	}
+	else if (data.layout == VertexLayout::INTERLEAVED_PACKED_NORMALS) {
+		appendBytes(result.vertices, data.interleavePacked());
+	}
+	else {
+		appendBytes(result.vertices, data.quantize(result.positionOffset, result.positionScale));
+	}
+
+	if (result.indexType == GL_UNSIGNED_SHORT) {
+		appendBytes(result.indices, std::vector<GLushort>(data.indices.begin(), data.indices.end()));
+	}
+	else {
+		appendBytes(result.indices, data.indices);
+	}
+	return result;
+}
+
+MeshData Mesh::prepare(const MeshCacheFile& file)
+{
+	MeshData result;
+	result.layout = VertexLayout::INTERLEAVED;
+	result.vertexCount = file.isValid() ? file.header().vertexCount : 0;
+	result.elements = file.isValid() ? file.header().indexCount : 0;
+	result.indexType = file.isValid() && file.header().indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	result.positionOffset = glm::vec3(0.0f);
+	result.positionScale = glm::vec3(1.0f);
+	result.bounds = Bounds::fromBox(glm::vec3(0.0f), glm::vec3(0.0f));
+	if (file.isValid()) {
+		const MeshCacheHeader& header = file.header();
+		result.bounds = Bounds::fromBox(glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]),
+			glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]));
+	}
+	// uploaded straight from the mapped file
+	result.cacheFile = file.isValid() ? &file : nullptr;
+	return result;
+}
+
+void Mesh::allocate(const MeshData& data, bool upload)
+{
+	_elements = data.elements;
+	_indexType = data.indexType;
+	_quantized = data.layout == VertexLayout::QUANTIZED;
+	_positionOffset = data.positionOffset;
+	_positionScale = data.positionScale;
+	_bounds = data.bounds;
+
+	// create VAO
+	glGenVertexArrays(1, &_vao);
+	GLState::bindVertexArray(_vao);
+
+	// create vertex VBO
+	glGenBuffers(1, &_vboVertices);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, _vboVertices);
+	glBufferData(GL_ARRAY_BUFFER, data.vertexDataSize(), upload ? data.vertexData() : nullptr, GL_STATIC_DRAW);
+	setVertexAttributes(data.layout, data.vertexCount);
+
+	// create and bind indices VBO
+	glGenBuffers(1, &_vboIndices);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _vboIndices);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indexDataSize(), upload ? data.indexData() : nullptr, GL_STATIC_DRAW);
+
+	setInstanceAttributes();
+
+	GLState::bindVertexArray(0);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+
+	_ready = upload;
+}
+
+void Mesh::setUniforms(Shader* shader) const
+{
+	shader->setUniform(QUANTIZED, _quantized ? 1 : 0);
+	shader->setUniform(POSITION_OFFSET, _positionOffset);
+	shader->setUniform(POSITION_SCALE, _positionScale);
+}
+
+void Mesh::draw() const
+{
+	if (!_ready) return;
+	bind();
+	drawElements();
+	GLState::bindVertexArray(0);
+}
+
+void Mesh::drawInstanced(GLuint instanceBuffer, GLsizei instanceCount) const
+{
+	if (!_ready) return;
+	bind();
+	drawElementsInstanced(instanceBuffer, 0, instanceCount);
+	GLState::bindVertexArray(0);
+}
+
+void Mesh::bind() const
+{
+	GLState::bindVertexArray(_vao);
+}
+
+void Mesh::drawElements() const
+{
+	if (!_ready) return;
+	glDrawElements(GL_TRIANGLES, _elements, _indexType, 0);
+}
+
+void Mesh::drawElementsInstanced(GLuint instanceBuffer, GLintptr offset, GLsizei instanceCount) const
+{
+	if (!_ready) return;
+	glBindVertexBuffer(INSTANCE_BINDING, instanceBuffer, offset, sizeof(InstanceData));
+	for (GLuint location = 3; location < 10; location++) glEnableVertexAttribArray(location);
+
+	glDrawElementsInstanced(GL_TRIANGLES, _elements, _indexType, 0, instanceCount);
+
+	// the VAO is shared with non-instanced draws, which must not read the instance buffer
+	for (GLuint location = 3; location < 10; location++) glDisableVertexAttribArray(location);
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <vector>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include "Geometry.h"
+#include "Shader.h"
+
+class MeshCacheFile;
+
+/*!
+ * Per-instance vertex data of instanced draws
+ * The model matrix is bound to locations 3-6, the normal matrix to locations 7-9.
+ */
+struct InstanceData {
+	glm::mat4 modelMatrix;
+	glm::mat3 normalMatrix;
+};
+
+/*!
+ * The vertex and index buffer contents of a mesh, ready to be copied to the GPU
+ * Created without any OpenGL calls, so it can be prepared on any thread.
+ */
+struct MeshData {
+	/*!
+	 * How the vertices are stored
+	 * SEPARATE stores all positions, then all normals, then all UVs.
+	 */
+	VertexLayout layout;
+	size_t vertexCount;
+	/*!
+	 * Number of indices and their type (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+	 */
+	unsigned int elements;
+	GLenum indexType;
+	/*!
+	 * Offset and scale that dequantize the vertex positions of the QUANTIZED layout
+	 */
+	glm::vec3 positionOffset, positionScale;
+	/*!
+	 * Bounds of the vertex positions
+	 */
+	Bounds bounds;
+
+	/*!
+	 * Owned buffer contents (empty if the data comes from a mesh cache file)
+	 */
+	std::vector<char> vertices, indices;
+	/*!
+	 * Mapped mesh cache file the buffer contents come from (nullptr if they are owned)
+	 * The file has to stay open until the data is uploaded.
+	 */
+	const MeshCacheFile* cacheFile;
+
+	const char* vertexData() const;
+	size_t vertexDataSize() const;
+	const char* indexData() const;
+	size_t indexDataSize() const;
+};
+
+/*!
+ * Vertex and index buffers of a mesh on the GPU
+ * A mesh is shared by all Geometry instances that draw it, see MeshRegistry.
+ */
+class Mesh
+{
+protected:
+	/*!
+	 * Vertex array object
+	 */
+	GLuint _vao;
+	/*!
+	 * Vertex buffer object that stores all vertex attributes
+	 */
+	GLuint _vboVertices;
+	/*!
+	 * Vertex buffer object that stores the indices
+	 */
+	GLuint _vboIndices;
+
+	/*!
+	 * Number of elements to be rendered
+	 */
+	unsigned int _elements;
+
+	/*!
+	 * Type of the indices (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+	 */
+	GLenum _indexType;
+
+	/*!
+	 * If the vertices are quantized and have to be decoded in the vertex shader
+	 */
+	bool _quantized;
+	/*!
+	 * Offset and scale that dequantize the vertex positions
+	 */
+	glm::vec3 _positionOffset, _positionScale;
+	/*!
+	 * Bounds of the vertex positions, used for culling
+	 */
+	Bounds _bounds;
+
+	/*!
+	 * If the buffers are complete, placeholder meshes draw nothing
+	 */
+	bool _ready;
+
+public:
+	/*!
+	 * Creates an empty placeholder mesh that draws nothing until it is allocated and ready
+	 */
+	Mesh();
+	/*!
+	 * Mesh constructor
+	 * Creates VAO and VBOs in the layout of the data and uploads the data
+	 * @param data: data for the mesh
+	 */
+	Mesh(const GeometryData& data);
+	/*!
+	 * Mesh constructor
+	 * Uploads the interleaved vertices and indices of a mapped mesh cache without copying them
+	 * @param file: the mapped mesh cache file
+	 */
+	Mesh(const MeshCacheFile& file);
+	~Mesh();
+
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+
+	/*!
+	 * Converts geometry data into the buffer contents of its vertex layout
+	 * @param data: the geometry data
+	 * @return the buffer contents
+	 */
+	static MeshData prepare(const GeometryData& data);
+	/*!
+	 * Describes the buffer contents of a mapped mesh cache file
+	 * @param file: the mapped mesh cache file, it has to stay open until the data is uploaded
+	 * @return the buffer contents
+	 */
+	static MeshData prepare(const MeshCacheFile& file);
+
+	/*!
+	 * Creates VAO and VBOs for the data
+	 * @param data: the buffer contents
+	 * @param upload: if the data is uploaded, otherwise the buffers are left uninitialized and the mesh is not ready
+	 */
+	void allocate(const MeshData& data, bool upload);
+
+	/*!
+	 * Marks the mesh as complete after its buffers were filled
+	 */
+	void setReady() { _ready = true; }
+	/*!
+	 * @return if the mesh is complete
+	 */
+	bool isReady() const { return _ready; }
+
+	/*!
+	 * @return the vertex buffer object
+	 */
+	GLuint getVertexBuffer() const { return _vboVertices; }
+	/*!
+	 * @return the index buffer object
+	 */
+	GLuint getIndexBuffer() const { return _vboIndices; }
+
+	/*!
+	 * Sets the uniforms the vertex shader needs to decode the vertices
+	 * @param shader: the shader in use
+	 */
+	void setUniforms(Shader* shader) const;
+
+	/*!
+	 * Binds the VAO and issues the draw call
+	 */
+	void draw() const;
+
+	/*!
+	 * Binds the VAO and issues one instanced draw call
+	 * @param instanceBuffer: buffer with one InstanceData element per instance
+	 * @param instanceCount: number of instances to draw
+	 */
+	void drawInstanced(GLuint instanceBuffer, GLsizei instanceCount) const;
+
+	/*!
+	 * Binds the VAO, for several draws of the mesh in a row
+	 */
+	void bind() const;
+	/*!
+	 * Issues the draw call, the VAO has to be bound
+	 */
+	void drawElements() const;
+	/*!
+	 * Issues one instanced draw call, the VAO has to be bound
+	 * @param instanceBuffer: buffer with one InstanceData element per instance
+	 * @param offset: offset of the first instance in the buffer in bytes
+	 * @param instanceCount: number of instances to draw
+	 */
+	void drawElementsInstanced(GLuint instanceBuffer, GLintptr offset, GLsizei instanceCount) const;
+
+	/*!
+	 * @return the number of indices
+	 */
+	unsigned int getElementCount() const { return _elements; }
+	/*!
+	 * @return the bounds of the vertex positions (zero sized for placeholder meshes)
+	 */
+	const Bounds& getBounds() const { return _bounds; }
+};
@@ -0,0 +1,191 @@
+#include "MeshCache.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+
+/* --------------------------------------------- */
+// Helpers
+/* --------------------------------------------- */
+
+static const char MESH_CACHE_MAGIC[4] = { 'S', 'R', 'M', 'C' };
+
+/*!
+ * Size and last write time of a file
+ */
+struct SourceInfo {
+	unsigned long long size;
+	unsigned long long time;
+};
+
+static bool getSourceInfo(const char* path, SourceInfo& info)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes)) return false;
+	info.size = (unsigned long long)attributes.nFileSizeHigh << 32 | attributes.nFileSizeLow;
+	info.time = (unsigned long long)attributes.ftLastWriteTime.dwHighDateTime << 32 | attributes.ftLastWriteTime.dwLowDateTime;
+	return true;
+}
+
+static unsigned long long hashFile(const char* path)
+{
+	MappedFile file(path);
+	unsigned long long hash = 0xCBF29CE484222325ULL;
+	for (size_t i = 0; i < file.size(); i++) {
+		hash ^= (unsigned char)file.data()[i];
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+/*!
+ * Stores a new source write time in the header of a cache file, the file must not be mapped
+ */
+static bool writeSourceTime(const std::string& path, unsigned long long time)
+{
+	FILE* file = fopen(path.c_str(), "r+b");
+	if (file == NULL) return false;
+	bool ok = fseek(file, long(offsetof(MeshCacheHeader, sourceTime)), SEEK_SET) == 0;
+	ok = ok && fwrite(&time, sizeof(time), 1, file) == 1;
+	return fclose(file) == 0 && ok;
+}
+
+/* --------------------------------------------- */
+// Mesh cache file
+/* --------------------------------------------- */
+
+MeshCacheFile::MeshCacheFile(const std::string& path)
+	: _file(path.c_str()), _header(nullptr)
+{
+	if (_file.size() < sizeof(MeshCacheHeader)) return;
+
+	const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(_file.data());
+	if (memcmp(header->magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 || header->version != MeshCache::VERSION) return;
+	if (header->vertexStride != sizeof(InterleavedVertex) || (header->indexSize != 2 && header->indexSize != 4)) return;
+
+	size_t expectedSize = sizeof(MeshCacheHeader) + size_t(header->vertexCount) * header->vertexStride + size_t(header->indexCount) * header->indexSize;
+	if (_file.size() != expectedSize) return;
+
+	_header = header;
+}
+
+GeometryData MeshCacheFile::toGeometryData() const
+{
+	GeometryData data;
+	if (!isValid()) return data;
+
+	const InterleavedVertex* vertices = static_cast<const InterleavedVertex*>(vertexData());
+	data.positions.reserve(_header->vertexCount);
+	data.normals.reserve(_header->vertexCount);
+	data.UVs.reserve(_header->vertexCount);
+	for (unsigned int i = 0; i < _header->vertexCount; i++) {
+		data.positions.push_back(vertices[i].position);
+		data.normals.push_back(vertices[i].normal);
+		data.UVs.push_back(vertices[i].uv);
+	}
+	if (_header->indexSize == 2) {
+		const unsigned short* indices = static_cast<const unsigned short*>(indexData());
+		data.indices.assign(indices, indices + _header->indexCount);
+	}
+	else {
+		const unsigned int* indices = static_cast<const unsigned int*>(indexData());
+		data.indices.assign(indices, indices + _header->indexCount);
+	}
+	data.computeBounds();
+	return data;
+}
+
+/* --------------------------------------------- */
+// Mesh cache
+/* --------------------------------------------- */
+
+std::string MeshCache::cachePath(const char* sourcePath)
+{
+	return std::string(sourcePath) + ".meshcache";
+}
+
+std::unique_ptr<MeshCacheFile> MeshCache::load(const char* sourcePath)
+{
+	// loader threads may load the same file, e.g. a mesh and its levels of detail, only one of them may rebuild it
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::string path = cachePath(sourcePath);
+	SourceInfo source;
+	bool sourceExists = getSourceInfo(sourcePath, source);
+
+	bool sameContent = false;
+	{
+		std::unique_ptr<MeshCacheFile> cache(new MeshCacheFile(path));
+		if (cache->isValid()) {
+			const MeshCacheHeader& header = cache->header();
+			// without the source the cache is all we have
+			if (!sourceExists) return cache;
+			if (header.sourceSize == source.size && header.sourceTime == source.time) return cache;
+			// the write time changes on checkout or copy, so compare the content before rebuilding
+			sameContent = header.sourceSize == source.size && header.sourceHash == hashFile(sourcePath);
+		}
+	}
+	// the content is unchanged: store the new write time once the cache is unmapped, so the next launch does not hash again
+	if (sameContent) {
+		if (!writeSourceTime(path, source.time)) {
+			std::cout << "ERROR: Could not update the source time of " << path << std::endl;
+		}
+		std::unique_ptr<MeshCacheFile> cache(new MeshCacheFile(path));
+		if (cache->isValid()) return cache;
+	}
+
+	GeometryData data = Geometry::createOBJGeometry(sourcePath);
+	if (data.indices.empty() || !write(sourcePath, data)) {
+		std::cout << "ERROR: Could not create mesh cache for " << sourcePath << std::endl;
+	}
+	return std::unique_ptr<MeshCacheFile>(new MeshCacheFile(path));
+}
+
+bool MeshCache::write(const char* sourcePath, const GeometryData& data)
+{
+	SourceInfo source;
+	if (!getSourceInfo(sourcePath, source)) return false;
+
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+	header.version = VERSION;
+	header.sourceSize = source.size;
+	header.sourceTime = source.time;
+	header.sourceHash = hashFile(sourcePath);
+	header.vertexCount = unsigned(data.positions.size());
+	header.indexCount = unsigned(data.indices.size());
+	header.indexSize = data.hasShortIndices() ? 2 : 4;
+	header.vertexStride = sizeof(InterleavedVertex);
+
+	Bounds bounds = data.bounds.isValid() ? data.bounds : Bounds::fromPoints(data.positions);
+	memcpy(header.boundsMin, &bounds.min[0], sizeof(header.boundsMin));
+	memcpy(header.boundsMax, &bounds.max[0], sizeof(header.boundsMax));
+
+	std::vector<InterleavedVertex> vertices = data.interleave();
+
+	// write to a temporary file first, so that a crash never leaves a broken cache behind
+	std::string path = cachePath(sourcePath);
+	std::string tempPath = path + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (file == NULL) return false;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && fwrite(vertices.data(), sizeof(InterleavedVertex), vertices.size(), file) == vertices.size();
+	if (header.indexSize == 2) {
+		std::vector<unsigned short> shortIndices(data.indices.begin(), data.indices.end());
+		ok = ok && fwrite(shortIndices.data(), sizeof(unsigned short), shortIndices.size(), file) == shortIndices.size();
+	}
+	else {
+		ok = ok && fwrite(data.indices.data(), sizeof(unsigned int), data.indices.size(), file) == data.indices.size();
+	}
+	ok = fclose(file) == 0 && ok;
+
+	if (!ok || !MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		DeleteFileA(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "Geometry.h"
+#include "Utils.h"
+
+/*!
+ * Header of a binary mesh cache file
+ * The header is followed by the interleaved vertex blob (InterleavedVertex)
+ * and the index blob (16 or 32 bit indices).
+ */
+struct MeshCacheHeader {
+	/*!
+	 * File identification, always "SRMC"
+	 */
+	char magic[4];
+	/*!
+	 * Format version, files with another version are rebuilt
+	 */
+	unsigned int version;
+	/*!
+	 * Size of the source file in bytes
+	 */
+	unsigned long long sourceSize;
+	/*!
+	 * Last write time of the source file
+	 */
+	unsigned long long sourceTime;
+	/*!
+	 * FNV-1a hash of the source file content
+	 */
+	unsigned long long sourceHash;
+	/*!
+	 * Number of vertices in the vertex blob
+	 */
+	unsigned int vertexCount;
+	/*!
+	 * Number of indices in the index blob
+	 */
+	unsigned int indexCount;
+	/*!
+	 * Size of one index in bytes (2 or 4)
+	 */
+	unsigned int indexSize;
+	/*!
+	 * Size of one vertex in bytes
+	 */
+	unsigned int vertexStride;
+	/*!
+	 * Minimum corner of the axis aligned bounding box
+	 */
+	float boundsMin[3];
+	/*!
+	 * Maximum corner of the axis aligned bounding box
+	 */
+	float boundsMax[3];
+};
+
+/*!
+ * A binary mesh cache file, mapped into memory
+ * The vertex and index blobs can be passed to glBufferData directly.
+ */
+class MeshCacheFile
+{
+protected:
+	MappedFile _file;
+	const MeshCacheHeader* _header;
+
+public:
+	/*!
+	 * Maps a mesh cache file
+	 * @param path: path to the cache file
+	 */
+	MeshCacheFile(const std::string& path);
+
+	/*!
+	 * @return if the file is a complete cache file of the current version
+	 */
+	bool isValid() const { return _header != nullptr; }
+	/*!
+	 * @return the header of the cache file
+	 */
+	const MeshCacheHeader& header() const { return *_header; }
+	/*!
+	 * @return pointer to the interleaved vertices
+	 */
+	const void* vertexData() const { return _file.data() + sizeof(MeshCacheHeader); }
+	/*!
+	 * @return size of the vertex blob in bytes
+	 */
+	size_t vertexDataSize() const { return size_t(_header->vertexCount) * _header->vertexStride; }
+	/*!
+	 * @return pointer to the indices
+	 */
+	const void* indexData() const { return _file.data() + sizeof(MeshCacheHeader) + vertexDataSize(); }
+	/*!
+	 * @return size of the index blob in bytes
+	 */
+	size_t indexDataSize() const { return size_t(_header->indexCount) * _header->indexSize; }
+
+	/*!
+	 * Copies the vertices and indices back into separate arrays, e.g. to simplify them without parsing the OBJ again
+	 * @return the geometry data of the cache (empty if the file is invalid)
+	 */
+	GeometryData toGeometryData() const;
+};
+
+/*!
+ * Binary mesh cache for OBJ files
+ * The cache is stored next to the source as "<source>.meshcache" and is rebuilt
+ * whenever the size, write time (and then content hash) of the source changes.
+ */
+class MeshCache
+{
+public:
+	/*!
+	 * Current version of the cache format
+	 */
+	static const unsigned int VERSION = 1;
+
+	/*!
+	 * Loads the cache of an OBJ file, (re)building it from the OBJ if necessary
+	 * Safe to call from several threads, the calls are serialized.
+	 * @param sourcePath: path to the OBJ file
+	 * @return the mapped cache file (invalid if neither the cache nor the OBJ could be loaded)
+	 */
+	static std::unique_ptr<MeshCacheFile> load(const char* sourcePath);
+
+	/*!
+	 * Writes the cache file of an OBJ file
+	 * @param sourcePath: path to the OBJ file
+	 * @param data: the loaded geometry data of the OBJ file
+	 * @return if the cache file could be written
+	 */
+	static bool write(const char* sourcePath, const GeometryData& data);
+
+	/*!
+	 * @param sourcePath: path to the OBJ file
+	 * @return path to the cache file of the OBJ file
+	 */
+	static std::string cachePath(const char* sourcePath);
+};
@@ -0,0 +1,204 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+
+/* --------------------------------------------- */
+// Helpers
+/* --------------------------------------------- */
+
+/*!
+ * Triangles adjacent to every vertex, stored as one compact array
+ */
+struct VertexAdjacency {
+	std::vector<unsigned int> offsets;
+	std::vector<unsigned int> triangles;
+
+	VertexAdjacency(const std::vector<unsigned int>& indices, size_t vertexCount)
+		: offsets(vertexCount + 1, 0), triangles(indices.size())
+	{
+		for (unsigned int index : indices) offsets[index + 1]++;
+		for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++) triangles[fill[indices[i]]++] = unsigned(i / 3);
+	}
+};
+
+/* --------------------------------------------- */
+// Mesh optimizer
+/* --------------------------------------------- */
+
+void MeshOptimizer::optimize(GeometryData& data, unsigned int cacheSize)
+{
+	std::vector<unsigned int> clusters = optimizeVertexCache(data, cacheSize);
+	optimizeOverdraw(data, clusters);
+	optimizeVertexFetch(data);
+}
+
+std::vector<unsigned int> MeshOptimizer::optimizeVertexCache(GeometryData& data, unsigned int cacheSize)
+{
+	const size_t vertexCount = data.positions.size();
+	const size_t triangleCount = data.indices.size() / 3;
+	std::vector<unsigned int> clusters;
+	if (triangleCount == 0) return clusters;
+
+	VertexAdjacency adjacency(data.indices, vertexCount);
+
+	std::vector<unsigned int> liveTriangles(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> deadEnd;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> result;
+	result.reserve(data.indices.size());
+
+	unsigned int time = cacheSize + 1;
+	size_t cursor = 0;
+	long fanning = 0;
+	clusters.push_back(0);
+
+	while (fanning >= 0) {
+		// emit all remaining triangles around the fanning vertex
+		candidates.clear();
+		for (unsigned int a = adjacency.offsets[fanning]; a < adjacency.offsets[fanning + 1]; a++) {
+			unsigned int triangle = adjacency.triangles[a];
+			if (emitted[triangle]) continue;
+
+			for (int corner = 0; corner < 3; corner++) {
+				unsigned int v = data.indices[triangle * 3 + corner];
+				result.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+				if (time - cacheTime[v] > cacheSize) cacheTime[v] = time++;
+			}
+			emitted[triangle] = true;
+		}
+
+		// continue with the candidate that stays in the cache the longest
+		long best = -1;
+		long bestPriority = -1;
+		for (unsigned int v : candidates) {
+			if (liveTriangles[v] == 0) continue;
+			long priority = 0;
+			if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize) priority = time - cacheTime[v];
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				best = v;
+			}
+		}
+
+		// no candidate left: restart from the dead-end stack or the next unfinished vertex
+		if (best < 0) {
+			while (!deadEnd.empty() && best < 0) {
+				unsigned int v = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveTriangles[v] > 0) best = v;
+			}
+			for (; best < 0 && cursor < vertexCount; cursor++) {
+				if (liveTriangles[cursor] > 0) best = long(cursor);
+			}
+			if (best >= 0 && result.size() / 3 > clusters.back()) clusters.push_back(unsigned(result.size() / 3));
+		}
+		fanning = best;
+	}
+
+	data.indices.swap(result);
+	return clusters;
+}
+
+void MeshOptimizer::optimizeOverdraw(GeometryData& data, const std::vector<unsigned int>& clusters)
+{
+	const size_t triangleCount = data.indices.size() / 3;
+	if (clusters.size() < 2) return;
+
+	glm::vec3 meshCenter = glm::vec3(0.0f);
+	for (const glm::vec3& position : data.positions) meshCenter += position;
+	meshCenter /= float(std::max<size_t>(data.positions.size(), 1));
+
+	// sort key: how much a cluster faces away from the mesh center, such clusters likely occlude the others
+	std::vector<std::pair<float, unsigned int>> sortKeys(clusters.size());
+	for (size_t c = 0; c < clusters.size(); c++) {
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		glm::vec3 center = glm::vec3(0.0f);
+		glm::vec3 normal = glm::vec3(0.0f);
+		float area = 0.0f;
+		for (size_t t = clusters[c]; t < end; t++) {
+			const glm::vec3& p0 = data.positions[data.indices[t * 3 + 0]];
+			const glm::vec3& p1 = data.positions[data.indices[t * 3 + 1]];
+			const glm::vec3& p2 = data.positions[data.indices[t * 3 + 2]];
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			float a = glm::length(n);
+			center += (p0 + p1 + p2) * (a / 3.0f);
+			normal += n;
+			area += a;
+		}
+		if (area > 0.0f) center /= area;
+		float normalLength = glm::length(normal);
+		float facing = normalLength > 0.0f ? glm::dot(center - meshCenter, normal / normalLength) : 0.0f;
+		sortKeys[c] = std::make_pair(-facing, unsigned(c));
+	}
+	std::stable_sort(sortKeys.begin(), sortKeys.end(),
+		[](const std::pair<float, unsigned int>& a, const std::pair<float, unsigned int>& b) { return a.first < b.first; });
+
+	std::vector<unsigned int> result;
+	result.reserve(data.indices.size());
+	for (const std::pair<float, unsigned int>& key : sortKeys) {
+		size_t c = key.second;
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		result.insert(result.end(), data.indices.begin() + clusters[c] * 3, data.indices.begin() + end * 3);
+	}
+	data.indices.swap(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(GeometryData& data)
+{
+	const unsigned int UNUSED = 0xFFFFFFFFu;
+	std::vector<unsigned int> remap(data.positions.size(), UNUSED);
+	unsigned int vertexCount = 0;
+	for (unsigned int& index : data.indices) {
+		if (remap[index] == UNUSED) remap[index] = vertexCount++;
+		index = remap[index];
+	}
+
+	GeometryData reordered;
+	reordered.positions.resize(vertexCount);
+	reordered.normals.resize(data.normals.empty() ? 0 : vertexCount);
+	reordered.UVs.resize(data.UVs.empty() ? 0 : vertexCount);
+	for (size_t v = 0; v < remap.size(); v++) {
+		if (remap[v] == UNUSED) continue;
+		reordered.positions[remap[v]] = data.positions[v];
+		if (!data.normals.empty()) reordered.normals[remap[v]] = data.normals[v];
+		if (!data.UVs.empty()) reordered.UVs[remap[v]] = data.UVs[v];
+	}
+	data.positions.swap(reordered.positions);
+	data.normals.swap(reordered.normals);
+	data.UVs.swap(reordered.UVs);
+}
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const GeometryData& data, unsigned int cacheSize)
+{
+	// FIFO cache: a vertex is a hit while fewer than cacheSize misses happened since it was loaded
+	std::vector<size_t> loadedAt(data.positions.size(), 0);
+	std::vector<bool> used(data.positions.size(), false);
+	size_t misses = 0;
+	size_t usedVertices = 0;
+	for (unsigned int index : data.indices) {
+		if (!used[index]) {
+			used[index] = true;
+			usedVertices++;
+		}
+		else if (misses - loadedAt[index] <= cacheSize) {
+			continue;
+		}
+		loadedAt[index] = misses;
+		misses++;
+	}
+
+	VertexCacheStats stats;
+	stats.transformedVertices = misses;
+	stats.acmr = data.indices.empty() ? 0.0f : float(misses) / float(data.indices.size() / 3);
+	stats.atvr = usedVertices == 0 ? 0.0f : float(misses) / float(usedVertices);
+	return stats;
+}
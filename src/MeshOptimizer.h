@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include "Geometry.h"
+
+/*!
+ * Statistics of a simulated post-transform vertex cache
+ */
+struct VertexCacheStats {
+	/*!
+	 * Average cache miss ratio, i.e. transformed vertices per triangle (best case 0.5)
+	 */
+	float acmr;
+	/*!
+	 * Average transform to vertex ratio, i.e. transformed vertices per used vertex (best case 1.0)
+	 */
+	float atvr;
+	/*!
+	 * Number of vertex shader invocations
+	 */
+	size_t transformedVertices;
+};
+
+/*!
+ * Reorders the triangles and vertices of indexed geometry data for the GPU
+ * 1. Tipsify triangle order for the post-transform vertex cache
+ * 2. Overdraw ordering of the resulting triangle clusters (outward facing clusters first)
+ * 3. Vertex fetch ordering, i.e. vertices are stored in the order they are first used
+ */
+class MeshOptimizer
+{
+public:
+	/*!
+	 * Runs all optimization steps
+	 * @param data: the indexed geometry data, modified in place
+	 * @param cacheSize: size of the post-transform vertex cache to optimize for
+	 */
+	static void optimize(GeometryData& data, unsigned int cacheSize = 16);
+
+	/*!
+	 * Reorders the triangles with the Tipsify algorithm (Sander et al. 2007)
+	 * @param data: the indexed geometry data, modified in place
+	 * @param cacheSize: size of the post-transform vertex cache to optimize for
+	 * @return the first triangle of every cluster (a cluster ends where Tipsify had to restart)
+	 */
+	static std::vector<unsigned int> optimizeVertexCache(GeometryData& data, unsigned int cacheSize = 16);
+
+	/*!
+	 * Sorts triangle clusters so that clusters facing away from the mesh center are drawn first
+	 * @param data: the indexed geometry data, modified in place
+	 * @param clusters: the first triangle of every cluster, in ascending order
+	 */
+	static void optimizeOverdraw(GeometryData& data, const std::vector<unsigned int>& clusters);
+
+	/*!
+	 * Reorders the vertices in the order of their first use, unused vertices are removed
+	 * @param data: the indexed geometry data, modified in place
+	 */
+	static void optimizeVertexFetch(GeometryData& data);
+
+	/*!
+	 * Simulates a FIFO post-transform vertex cache
+	 * @param data: the indexed geometry data
+	 * @param cacheSize: size of the simulated cache
+	 * @return the cache statistics
+	 */
+	static VertexCacheStats analyzeVertexCache(const GeometryData& data, unsigned int cacheSize = 16);
+};
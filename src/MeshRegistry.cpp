@@ -0,0 +1,99 @@
+#include "MeshRegistry.h"
+#include <mutex>
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+
+MeshRegistry::MeshRegistry(AssetLoader* loader)
+	: _loads(0), _hits(0), _loader(loader)
+{
+}
+
+std::string MeshRegistry::key(const std::string& name, VertexLayout layout)
+{
+	return name + "#" + std::to_string(int(layout));
+}
+
+std::shared_ptr<Mesh> MeshRegistry::find(const std::string& key)
+{
+	auto it = _meshes.find(key);
+	if (it == _meshes.end()) return nullptr;
+	std::shared_ptr<Mesh> mesh = it->second.lock();
+	if (mesh == nullptr) _meshes.erase(it);
+	return mesh;
+}
+
+std::shared_ptr<Mesh> MeshRegistry::load(const std::string& path, VertexLayout layout)
+{
+	if (layout != VertexLayout::INTERLEAVED) {
+		return get(path, layout, [path]() { return Geometry::createOBJGeometry(path.c_str()); });
+	}
+
+	std::string meshKey = key(path, layout);
+	std::shared_ptr<Mesh> mesh = find(meshKey);
+	if (mesh != nullptr) {
+		_hits++;
+		return mesh;
+	}
+
+	mesh = _loader != nullptr ? _loader->loadMeshCache(path) : std::make_shared<Mesh>(*MeshCache::load(path.c_str()));
+	_meshes[meshKey] = mesh;
+	_loads++;
+	return mesh;
+}
+
+std::shared_ptr<Mesh> MeshRegistry::get(const std::string& name, VertexLayout layout, const std::function<GeometryData()>& create)
+{
+	std::string meshKey = key(name, layout);
+	std::shared_ptr<Mesh> mesh = find(meshKey);
+	if (mesh != nullptr) {
+		_hits++;
+		return mesh;
+	}
+
+	if (_loader != nullptr) {
+		mesh = _loader->loadMesh(create, layout);
+	}
+	else {
+		GeometryData data = create();
+		data.layout = layout;
+		mesh = std::make_shared<Mesh>(data);
+	}
+	_meshes[meshKey] = mesh;
+	_loads++;
+	return mesh;
+}
+
+std::vector<std::shared_ptr<Mesh>> MeshRegistry::getLODs(const std::string& name, VertexLayout layout, unsigned int count, const std::function<GeometryData(unsigned int)>& create)
+{
+	std::vector<std::shared_ptr<Mesh>> lods;
+	for (unsigned int lod = 0; lod < count; lod++) {
+		lods.push_back(get(lod == 0 ? name : name + " lod " + std::to_string(lod), layout, [create, lod]() { return create(lod); }));
+	}
+	return lods;
+}
+
+std::vector<std::shared_ptr<Mesh>> MeshRegistry::loadLODs(const std::string& path, VertexLayout layout, unsigned int count)
+{
+	// the coarser levels share one chain: the source is read from the mesh cache once and every level simplifies
+	// the one before, the levels may be created on different loader threads
+	struct LODChain {
+		std::mutex mutex;
+		std::vector<GeometryData> levels;
+	};
+	std::shared_ptr<LODChain> chain = std::make_shared<LODChain>();
+	std::vector<std::shared_ptr<Mesh>> lods;
+	lods.push_back(load(path, layout));
+	for (unsigned int lod = 1; lod < count; lod++) {
+		lods.push_back(get(path + " lod " + std::to_string(lod), layout, [path, chain, lod]() {
+			std::lock_guard<std::mutex> lock(chain->mutex);
+			if (chain->levels.empty()) chain->levels.push_back(MeshCache::load(path.c_str())->toGeometryData());
+			while (chain->levels.size() <= lod) {
+				GeometryData data = chain->levels.back();
+				MeshSimplifier::simplify(data, data.indices.size() / 3 / 2);
+				chain->levels.push_back(std::move(data));
+			}
+			return chain->levels[lod];
+		}));
+	}
+	return lods;
+}
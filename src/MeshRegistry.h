@@ -0,0 +1,100 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "Geometry.h"
+#include "Mesh.h"
+#include "AssetLoader.h"
+
+/*!
+ * Hands out shared meshes, so that every mesh is loaded and uploaded only once
+ * Meshes are keyed by their name (the path for OBJ files) and vertex layout.
+ * The registry does not keep meshes alive, a mesh is deleted with its last Geometry instance.
+ */
+class MeshRegistry
+{
+protected:
+	/*!
+	 * Meshes by key
+	 */
+	std::unordered_map<std::string, std::weak_ptr<Mesh>> _meshes;
+	/*!
+	 * Number of meshes that had to be created
+	 */
+	size_t _loads;
+	/*!
+	 * Number of requests served with an existing mesh
+	 */
+	size_t _hits;
+	/*!
+	 * Loads the meshes in the background if set
+	 */
+	AssetLoader* _loader;
+
+	/*!
+	 * @return the key of a mesh
+	 */
+	static std::string key(const std::string& name, VertexLayout layout);
+
+	/*!
+	 * @return the existing mesh of a key (nullptr if there is none)
+	 */
+	std::shared_ptr<Mesh> find(const std::string& key);
+
+public:
+	/*!
+	 * @param loader: loads the meshes in the background if set, the registry then hands out placeholder meshes
+	 */
+	MeshRegistry(AssetLoader* loader = nullptr);
+
+	/*!
+	 * Returns the mesh of an OBJ file, loading and uploading it on first use
+	 * The interleaved layout is loaded from the binary mesh cache.
+	 * @param path: path to the OBJ file
+	 * @param layout: vertex layout of the mesh
+	 * @return the shared mesh
+	 */
+	std::shared_ptr<Mesh> load(const std::string& path, VertexLayout layout = VertexLayout::INTERLEAVED);
+
+	/*!
+	 * Returns a procedural mesh, creating and uploading it on first use
+	 * @param name: unique name of the mesh including its parameters, e.g. "sphere 30 15 1.0"
+	 * @param layout: vertex layout of the mesh
+	 * @param create: creates the geometry data, only called if the mesh does not exist yet
+	 * @return the shared mesh
+	 */
+	std::shared_ptr<Mesh> get(const std::string& name, VertexLayout layout, const std::function<GeometryData()>& create);
+
+	/*!
+	 * Returns the levels of detail of a procedural mesh, finest first
+	 * Level i is registered as "<name> lod <i>", level 0 under the name itself.
+	 * @param name: unique name of the finest level including its parameters
+	 * @param layout: vertex layout of the meshes
+	 * @param count: number of levels
+	 * @param create: creates the geometry data of a level, e.g. with fewer segments for coarser levels
+	 * @return the shared meshes
+	 */
+	std::vector<std::shared_ptr<Mesh>> getLODs(const std::string& name, VertexLayout layout, unsigned int count, const std::function<GeometryData(unsigned int)>& create);
+	/*!
+	 * Returns the levels of detail of an OBJ file, finest first
+	 * Level 0 is the file itself, every further level is simplified to half the triangles of the one before.
+	 * The coarser levels are built one after the other from the mesh cache, the OBJ is never parsed for them.
+	 * @param path: path to the OBJ file
+	 * @param layout: vertex layout of the meshes
+	 * @param count: number of levels
+	 * @return the shared meshes
+	 */
+	std::vector<std::shared_ptr<Mesh>> loadLODs(const std::string& path, VertexLayout layout, unsigned int count);
+
+	/*!
+	 * @return the number of meshes that had to be created
+	 */
+	size_t getLoadCount() const { return _loads; }
+	/*!
+	 * @return the number of requests served with an existing mesh
+	 */
+	size_t getHitCount() const { return _hits; }
+};
@@ -0,0 +1,280 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include "MeshOptimizer.h"
+
+/* --------------------------------------------- */
+// Helpers
+/* --------------------------------------------- */
+
+/*!
+ * Smallest cosine between the normals of a triangle before and after a collapse (about 78 degrees)
+ * Rejecting only reversed normals lets triangles tilt a little in every pass until they face inward,
+ * which happens when a level is simplified from an already simplified one.
+ */
+static const double MIN_NORMAL_COS = 0.2;
+
+/*!
+ * Sum of the squared distances to a set of planes, weighted by the area of their triangles
+ */
+struct Quadric {
+	double a2, b2, c2, ab, ac, bc, ad, bd, cd, d2;
+	double weight;
+
+	Quadric()
+		: a2(0.0), b2(0.0), c2(0.0), ab(0.0), ac(0.0), bc(0.0), ad(0.0), bd(0.0), cd(0.0), d2(0.0), weight(0.0)
+	{
+	}
+
+	/*!
+	 * @param n: unit normal of the plane
+	 * @param d: distance of the plane, dot(n, p) + d = 0 on the plane
+	 * @param w: weight of the plane
+	 */
+	Quadric(const glm::dvec3& n, double d, double w)
+		: a2(w * n.x * n.x), b2(w * n.y * n.y), c2(w * n.z * n.z), ab(w * n.x * n.y), ac(w * n.x * n.z), bc(w * n.y * n.z),
+		ad(w * n.x * d), bd(w * n.y * d), cd(w * n.z * d), d2(w * d * d), weight(w)
+	{
+	}
+
+	void add(const Quadric& q)
+	{
+		a2 += q.a2; b2 += q.b2; c2 += q.c2;
+		ab += q.ab; ac += q.ac; bc += q.bc;
+		ad += q.ad; bd += q.bd; cd += q.cd;
+		d2 += q.d2;
+		weight += q.weight;
+	}
+
+	/*!
+	 * @return the weighted sum of the squared distances of a point to the planes
+	 */
+	double evaluate(const glm::vec3& p) const
+	{
+		double x = p.x, y = p.y, z = p.z;
+		return a2 * x * x + b2 * y * y + c2 * z * z + 2.0 * (ab * x * y + ac * x * z + bc * y * z)
+			+ 2.0 * (ad * x + bd * y + cd * z) + d2;
+	}
+};
+
+/*!
+ * Moves all vertices of one position onto a neighboring position
+ */
+struct Collapse {
+	unsigned int from, to;
+	/*!
+	 * Mean squared distance of the target to the planes of both positions
+	 */
+	double error;
+
+	bool operator<(const Collapse& other) const { return error < other.error; }
+};
+
+/*!
+ * Hash of a position for welding, consistent with == (-0 and 0 hash alike)
+ */
+struct PositionHash {
+	size_t operator()(const glm::vec3& p) const
+	{
+		uint32_t bits[3];
+		glm::vec3 q = p + glm::vec3(0.0f);
+		memcpy(bits, &q[0], sizeof(bits));
+		return size_t(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+	}
+};
+
+static glm::dvec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+	return glm::cross(glm::dvec3(b) - glm::dvec3(a), glm::dvec3(c) - glm::dvec3(a));
+}
+
+/* --------------------------------------------- */
+// Mesh simplifier
+/* --------------------------------------------- */
+
+float MeshSimplifier::simplify(GeometryData& data, size_t targetTriangles, float maxError)
+{
+	const size_t vertexCount = data.positions.size();
+	std::vector<unsigned int>& indices = data.indices;
+	const unsigned int UNUSED = 0xFFFFFFFFu;
+
+	// weld vertices with equal positions, the topology ignores normal and UV splits
+	std::vector<unsigned int> positionIds(vertexCount);
+	std::vector<glm::vec3> positions;
+	{
+		std::unordered_map<glm::vec3, unsigned int, PositionHash> ids;
+		ids.reserve(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++) {
+			auto result = ids.emplace(data.positions[v], unsigned(positions.size()));
+			if (result.second) positions.push_back(data.positions[v]);
+			positionIds[v] = result.first->second;
+		}
+	}
+	const size_t positionCount = positions.size();
+
+	// vertices of every position, to pick the closest split when a position collapses
+	std::vector<unsigned int> splitOffsets(positionCount + 1, 0);
+	std::vector<unsigned int> splits(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) splitOffsets[positionIds[v] + 1]++;
+	for (size_t p = 0; p < positionCount; p++) splitOffsets[p + 1] += splitOffsets[p];
+	{
+		std::vector<unsigned int> fill(splitOffsets.begin(), splitOffsets.end() - 1);
+		for (size_t v = 0; v < vertexCount; v++) splits[fill[positionIds[v]]++] = unsigned(v);
+	}
+
+	// quadrics of the triangle planes and edges that only have one triangle (or more than two)
+	std::vector<Quadric> quadrics(positionCount);
+	std::unordered_map<uint64_t, int> edgeTriangles;
+	edgeTriangles.reserve(indices.size());
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		unsigned int p[3] = { positionIds[indices[i]], positionIds[indices[i + 1]], positionIds[indices[i + 2]] };
+		glm::dvec3 n = triangleNormal(positions[p[0]], positions[p[1]], positions[p[2]]);
+		double length = glm::length(n);
+		if (length > 0.0) {
+			n /= length;
+			Quadric q(n, -glm::dot(n, glm::dvec3(positions[p[0]])), 0.5 * length);
+			for (unsigned int position : p) quadrics[position].add(q);
+		}
+		for (int e = 0; e < 3; e++) {
+			uint64_t a = std::min(p[e], p[(e + 1) % 3]), b = std::max(p[e], p[(e + 1) % 3]);
+			edgeTriangles[(a << 32) | b]++;
+		}
+	}
+	std::vector<unsigned char> locked(positionCount, 0);
+	for (const auto& edge : edgeTriangles) {
+		if (edge.second == 2) continue;
+		locked[unsigned(edge.first >> 32)] = 1;
+		locked[unsigned(edge.first & 0xFFFFFFFFu)] = 1;
+	}
+
+	const double maxErrorSquared = double(maxError) * double(maxError);
+	double largestError = 0.0;
+	size_t triangleCount = indices.size() / 3;
+	std::vector<unsigned int> adjacencyOffsets(positionCount + 1), adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<unsigned int> target(positionCount);
+	std::vector<unsigned char> touched(positionCount);
+	std::vector<unsigned int> vertexTarget(vertexCount);
+	std::vector<uint64_t> neighbors;
+
+	// every pass collapses independent edges, cheapest first, until the target is reached
+	while (triangleCount > targetTriangles) {
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (unsigned int index : indices) adjacencyOffsets[positionIds[index] + 1]++;
+		for (size_t p = 0; p < positionCount; p++) adjacencyOffsets[p + 1] += adjacencyOffsets[p];
+		adjacency.resize(indices.size());
+		{
+			std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++) adjacency[fill[positionIds[indices[i]]]++] = unsigned(i / 3);
+		}
+
+		collapses.clear();
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			for (int e = 0; e < 3; e++) {
+				unsigned int a = positionIds[indices[i + e]], b = positionIds[indices[i + (e + 1) % 3]];
+				Quadric q = quadrics[a];
+				q.add(quadrics[b]);
+				if (!locked[a]) collapses.push_back({ a, b, q.weight > 0.0 ? q.evaluate(positions[b]) / q.weight : 0.0 });
+				if (!locked[b]) collapses.push_back({ b, a, q.weight > 0.0 ? q.evaluate(positions[a]) / q.weight : 0.0 });
+			}
+		}
+		std::sort(collapses.begin(), collapses.end());
+
+		for (size_t p = 0; p < positionCount; p++) target[p] = unsigned(p);
+		std::fill(touched.begin(), touched.end(), 0);
+		size_t applied = 0;
+		for (const Collapse& collapse : collapses) {
+			if (triangleCount <= targetTriangles || collapse.error > maxErrorSquared) break;
+			// the triangles around a touched position changed in this pass
+			if (touched[collapse.from] || touched[collapse.to]) continue;
+
+			size_t removed = 0;
+			bool flips = false;
+			for (unsigned int a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && !flips; a++) {
+				unsigned int t = adjacency[a];
+				unsigned int p[3] = { positionIds[indices[t * 3]], positionIds[indices[t * 3 + 1]], positionIds[indices[t * 3 + 2]] };
+				if (p[0] == collapse.to || p[1] == collapse.to || p[2] == collapse.to) {
+					removed++;
+					continue;
+				}
+				glm::vec3 moved[3];
+				for (int c = 0; c < 3; c++) moved[c] = positions[p[c] == collapse.from ? collapse.to : p[c]];
+				glm::dvec3 before = triangleNormal(positions[p[0]], positions[p[1]], positions[p[2]]);
+				glm::dvec3 after = triangleNormal(moved[0], moved[1], moved[2]);
+				double lengths = glm::length(before) * glm::length(after);
+				flips = !(glm::dot(before, after) > MIN_NORMAL_COS * lengths);
+			}
+			if (flips) continue;
+
+			// link condition: the positions next to both ends have to be the corners opposite the edge,
+			// otherwise the collapse pinches the surface into non-manifold edges
+			neighbors.clear();
+			for (unsigned int position : { collapse.from, collapse.to }) {
+				for (unsigned int a = adjacencyOffsets[position]; a < adjacencyOffsets[position + 1]; a++) {
+					unsigned int t = adjacency[a];
+					for (int c = 0; c < 3; c++) {
+						unsigned int neighbor = positionIds[indices[t * 3 + c]];
+						if (neighbor != collapse.from && neighbor != collapse.to) neighbors.push_back(uint64_t(neighbor) << 1 | (position == collapse.to ? 1 : 0));
+					}
+				}
+			}
+			std::sort(neighbors.begin(), neighbors.end());
+			neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+			size_t shared = 0;
+			for (size_t n = 1; n < neighbors.size(); n++) {
+				if (neighbors[n] >> 1 == neighbors[n - 1] >> 1) shared++;
+			}
+			if (shared != removed) continue;
+
+			target[collapse.from] = collapse.to;
+			quadrics[collapse.to].add(quadrics[collapse.from]);
+			for (unsigned int a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++) {
+				unsigned int t = adjacency[a];
+				for (int c = 0; c < 3; c++) touched[positionIds[indices[t * 3 + c]]] = 1;
+			}
+			triangleCount -= removed;
+			largestError = std::max(largestError, collapse.error);
+			applied++;
+		}
+		if (applied == 0) break;
+
+		// move the vertices of collapsed positions onto the split of the target with the closest attributes
+		std::fill(vertexTarget.begin(), vertexTarget.end(), UNUSED);
+		for (unsigned int& index : indices) {
+			unsigned int to = target[positionIds[index]];
+			if (to == positionIds[index]) continue;
+			if (vertexTarget[index] == UNUSED) {
+				float bestDistance = FLT_MAX;
+				for (unsigned int s = splitOffsets[to]; s < splitOffsets[to + 1]; s++) {
+					unsigned int split = splits[s];
+					float distance = 0.0f;
+					if (!data.normals.empty()) distance += glm::dot(data.normals[split] - data.normals[index], data.normals[split] - data.normals[index]);
+					if (!data.UVs.empty()) distance += glm::dot(data.UVs[split] - data.UVs[index], data.UVs[split] - data.UVs[index]);
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						vertexTarget[index] = split;
+					}
+				}
+			}
+			index = vertexTarget[index];
+		}
+
+		// drop the triangles that collapsed into lines
+		size_t kept = 0;
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			unsigned int a = positionIds[indices[i]], b = positionIds[indices[i + 1]], c = positionIds[indices[i + 2]];
+			if (a == b || b == c || c == a) continue;
+			for (int k = 0; k < 3; k++) indices[kept + k] = indices[i + k];
+			kept += 3;
+		}
+		indices.resize(kept);
+		triangleCount = kept / 3;
+	}
+
+	MeshOptimizer::optimize(data);
+	data.computeBounds();
+	return float(std::sqrt(largestError));
+}
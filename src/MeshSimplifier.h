@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cfloat>
+#include <vector>
+#include "Geometry.h"
+
+/*!
+ * Reduces the triangle count of indexed geometry data for coarser levels of detail
+ * Edges are collapsed in the order of their quadric error (Garland and Heckbert 1997). A vertex always moves onto
+ * one of its neighbors, so no new positions or attributes are invented. Topology is computed on positions, so
+ * vertices that are split for normals or UVs collapse together and take the attributes of the closest split of the target.
+ * Open borders are locked, so holes do not grow, and collapses that flip a triangle are rejected.
+ */
+class MeshSimplifier
+{
+public:
+	/*!
+	 * Collapses edges until the triangle count is reached, the error limit is hit or no edge can collapse
+	 * The result is optimized with MeshOptimizer and its bounds are computed again.
+	 * @param data: the indexed geometry data, modified in place
+	 * @param targetTriangles: the number of triangles to reduce to
+	 * @param maxError: largest allowed distance to the original surface in model units
+	 * @return the largest error of an applied collapse, in model units
+	 */
+	static float simplify(GeometryData& data, size_t targetTriangles, float maxError = FLT_MAX);
+};
@@ -0,0 +1,341 @@
+#include "OBJLoader.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+/* --------------------------------------------- */
+// Scanner helpers
+/* --------------------------------------------- */
+
+/*!
+ * One corner of a face, as zero based indices (-1 if not given)
+ */
+struct OBJCorner {
+	long position;
+	long uv;
+	long normal;
+};
+
+static inline bool operator==(const OBJCorner& a, const OBJCorner& b)
+{
+	return a.position == b.position && a.uv == b.uv && a.normal == b.normal;
+}
+
+static inline size_t hashCorner(const OBJCorner& corner)
+{
+	unsigned long long h = (unsigned long long)corner.position * 0x9E3779B97F4A7C15ULL;
+	h ^= ((unsigned long long)corner.uv + 0x7F4A7C15ULL) * 0xC2B2AE3D27D4EB4FULL;
+	h ^= ((unsigned long long)corner.normal + 0x165667B1ULL) * 0x165667B19E3779F9ULL;
+	return size_t(h ^ (h >> 29));
+}
+
+static const unsigned int EMPTY_SLOT = 0xFFFFFFFFu;
+
+static const double POWERS_OF_TEN[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isDigit(char c)
+{
+	return unsigned(c - '0') < 10u;
+}
+
+static inline const char* skipBlanks(const char* p, const char* end)
+{
+	while (p < end && isBlank(*p)) p++;
+	return p;
+}
+
+static inline const char* findLineEnd(const char* p, const char* end)
+{
+	const void* newline = memchr(p, '\n', end - p);
+	return newline != nullptr ? static_cast<const char*>(newline) : end;
+}
+
+static inline const char* findCommentStart(const char* p, const char* end)
+{
+	const void* comment = memchr(p, '#', end - p);
+	return comment != nullptr ? static_cast<const char*>(comment) : end;
+}
+
+static inline bool isKeyword(const char* p, const char* end, const char* keyword, size_t length)
+{
+	return size_t(end - p) > length && memcmp(p, keyword, length) == 0 && isBlank(p[length]);
+}
+
+/*!
+ * Parses a decimal floating point number, e.g. "-1.25e-3"
+ * @return the position after the number, or p if there is no number
+ */
+static const char* parseFloat(const char* p, const char* end, float& result)
+{
+	const char* start = p;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+	// collect up to 19 significant digits, further digits only shift the exponent
+	unsigned long long mantissa = 0;
+	int exponent = 0;
+	int digits = 0;
+	for (; p < end && isDigit(*p); p++, digits++) {
+		if (mantissa < 1000000000000000000ULL) mantissa = mantissa * 10 + (*p - '0');
+		else exponent++;
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && isDigit(*p); p++, digits++) {
+			if (mantissa < 1000000000000000000ULL) {
+				mantissa = mantissa * 10 + (*p - '0');
+				exponent--;
+			}
+		}
+	}
+	if (digits == 0) return start;
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		const char* e = p + 1;
+		bool negativeExponent = false;
+		if (e < end && (*e == '-' || *e == '+')) negativeExponent = *e++ == '-';
+		if (e < end && isDigit(*e)) {
+			int value = 0;
+			for (; e < end && isDigit(*e); e++) {
+				if (value < 10000) value = value * 10 + (*e - '0');
+			}
+			exponent += negativeExponent ? -value : value;
+			p = e;
+		}
+	}
+
+	double value = double(mantissa);
+	if (exponent < 0) value = exponent >= -22 ? value / POWERS_OF_TEN[-exponent] : value * std::pow(10.0, exponent);
+	else if (exponent > 0) value = exponent <= 22 ? value * POWERS_OF_TEN[exponent] : value * std::pow(10.0, exponent);
+
+	result = float(negative ? -value : value);
+	return p;
+}
+
+/*!
+ * Parses a (possibly negative) decimal integer
+ * @return the position after the number, or p if there is no number
+ */
+static const char* parseInt(const char* p, const char* end, long& result)
+{
+	const char* start = p;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+	if (p >= end || !isDigit(*p)) return start;
+
+	long value = 0;
+	for (; p < end && isDigit(*p); p++) value = value * 10 + (*p - '0');
+	result = negative ? -value : value;
+	return p;
+}
+
+/*!
+ * Converts an OBJ index (1 based, or negative relative to the end) into a zero based index
+ * @param index: the index as written in the file
+ * @param count: number of elements read so far
+ * @return the zero based index, or -1 if it is out of range
+ */
+static inline long resolveIndex(long index, size_t count)
+{
+	if (index > 0 && size_t(index) <= count) return index - 1;
+	if (index < 0 && size_t(-index) <= count) return long(count) + index;
+	return -1;
+}
+
+/*!
+ * Parses one face corner in the form v, v/vt, v//vn or v/vt/vn
+ * @return the position after the corner, or nullptr if the corner is invalid
+ */
+static const char* parseCorner(const char* p, const char* end, OBJCorner& corner, size_t positionCount, size_t uvCount, size_t normalCount)
+{
+	long position = 0, uv = 0, normal = 0;
+	const char* q = parseInt(p, end, position);
+	if (q == p) return nullptr;
+
+	if (q < end && *q == '/') {
+		q++;
+		if (q < end && *q != '/') {
+			const char* next = parseInt(q, end, uv);
+			if (next == q) return nullptr;
+			q = next;
+		}
+		if (q < end && *q == '/') {
+			q++;
+			const char* next = parseInt(q, end, normal);
+			if (next == q) return nullptr;
+			q = next;
+		}
+	}
+	if (q < end && !isBlank(*q)) return nullptr;
+
+	corner.position = resolveIndex(position, positionCount);
+	corner.uv = uv != 0 ? resolveIndex(uv, uvCount) : -1;
+	corner.normal = normal != 0 ? resolveIndex(normal, normalCount) : -1;
+	if (corner.position < 0 || (uv != 0 && corner.uv < 0) || (normal != 0 && corner.normal < 0)) return nullptr;
+	return q;
+}
+
+/*!
+ * Counts the corners of a face line (everything after the "f")
+ */
+static size_t countCorners(const char* p, const char* end)
+{
+	size_t corners = 0;
+	bool inCorner = false;
+	for (; p < end; p++) {
+		bool blank = isBlank(*p);
+		if (!blank && !inCorner) corners++;
+		inCorner = !blank;
+	}
+	return corners;
+}
+
+/* --------------------------------------------- */
+// OBJ loader
+/* --------------------------------------------- */
+
+bool OBJLoader::load(const char* path, GeometryData& data)
+{
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		std::cout << "ERROR: Could not open OBJ file " << path << std::endl;
+		return false;
+	}
+	return parse(file.data(), file.size(), data);
+}
+
+bool OBJLoader::parse(const char* text, size_t length, GeometryData& data)
+{
+	const char* end = text + length;
+
+	// first pass: count all elements, so that every array is allocated exactly once
+	size_t positionCount = 0, uvCount = 0, normalCount = 0, triangleCount = 0;
+	for (const char* line = text; line < end; ) {
+		const char* lineEnd = findLineEnd(line, end);
+		const char* p = skipBlanks(line, lineEnd);
+
+		if (isKeyword(p, lineEnd, "v", 1)) positionCount++;
+		else if (isKeyword(p, lineEnd, "vt", 2)) uvCount++;
+		else if (isKeyword(p, lineEnd, "vn", 2)) normalCount++;
+		else if (isKeyword(p, lineEnd, "f", 1)) {
+			size_t corners = countCorners(p + 1, findCommentStart(p, lineEnd));
+			if (corners >= 3) triangleCount += corners - 2;
+		}
+
+		line = lineEnd < end ? lineEnd + 1 : end;
+	}
+
+	std::vector<glm::vec3> positions(positionCount);
+	std::vector<glm::vec2> uvs(uvCount);
+	std::vector<glm::vec3> normals(normalCount);
+
+	// at most every corner is a unique vertex, the arrays are shrunk after parsing
+	size_t maxVertices = triangleCount * 3;
+	data.positions.resize(maxVertices);
+	data.normals.resize(maxVertices);
+	data.UVs.resize(maxVertices);
+	data.indices.resize(maxVertices);
+
+	// open addressing hash table that maps corners (position/uv/normal triples) to unique vertices
+	size_t slotCount = 16;
+	while (slotCount < maxVertices * 2) slotCount *= 2;
+	std::vector<unsigned int> slots(slotCount, EMPTY_SLOT);
+	std::vector<OBJCorner> vertexKeys(maxVertices);
+
+	// second pass: parse the vertex attributes, triangulate the faces and deduplicate the vertices
+	size_t positionsRead = 0, uvsRead = 0, normalsRead = 0;
+	size_t vertexCount = 0, index = 0;
+	size_t lineNumber = 0;
+	for (const char* line = text; line < end; ) {
+		const char* lineEnd = findLineEnd(line, end);
+		const char* p = skipBlanks(line, lineEnd);
+		lineNumber++;
+
+		if (isKeyword(p, lineEnd, "v", 1)) {
+			glm::vec3& position = positions[positionsRead++];
+			p = parseFloat(skipBlanks(p + 1, lineEnd), lineEnd, position.x);
+			p = parseFloat(skipBlanks(p, lineEnd), lineEnd, position.y);
+			parseFloat(skipBlanks(p, lineEnd), lineEnd, position.z);
+		}
+		else if (isKeyword(p, lineEnd, "vt", 2)) {
+			glm::vec2& uv = uvs[uvsRead++];
+			p = parseFloat(skipBlanks(p + 2, lineEnd), lineEnd, uv.x);
+			parseFloat(skipBlanks(p, lineEnd), lineEnd, uv.y);
+		}
+		else if (isKeyword(p, lineEnd, "vn", 2)) {
+			glm::vec3& normal = normals[normalsRead++];
+			p = parseFloat(skipBlanks(p + 2, lineEnd), lineEnd, normal.x);
+			p = parseFloat(skipBlanks(p, lineEnd), lineEnd, normal.y);
+			parseFloat(skipBlanks(p, lineEnd), lineEnd, normal.z);
+		}
+		else if (isKeyword(p, lineEnd, "f", 1)) {
+			const char* faceEnd = findCommentStart(p, lineEnd);
+			OBJCorner first, previous, current;
+			size_t corners = 0;
+
+			for (p = skipBlanks(p + 1, faceEnd); p < faceEnd; p = skipBlanks(p, faceEnd)) {
+				p = parseCorner(p, faceEnd, current, positionsRead, uvsRead, normalsRead);
+				if (p == nullptr) {
+					std::cout << "ERROR: Invalid face in OBJ line " << lineNumber << std::endl;
+					data = GeometryData();
+					return false;
+				}
+
+				if (corners == 0) first = current;
+				if (corners >= 2) {
+					// fan triangulation around the first corner
+					const OBJCorner triangle[3] = { first, previous, current };
+
+					// faces without normals get their flat face normal
+					glm::vec3 faceNormal = glm::vec3(0.0f, 1.0f, 0.0f);
+					if (first.normal < 0 || previous.normal < 0 || current.normal < 0) {
+						glm::vec3 n = glm::cross(
+							positions[previous.position] - positions[first.position],
+							positions[current.position] - positions[first.position]);
+						float nLength = glm::length(n);
+						if (nLength > 0.0f) faceNormal = n / nLength;
+					}
+
+					for (const OBJCorner& corner : triangle) {
+						// corners with a generated face normal are only shared within their triangle
+						OBJCorner key = corner;
+						if (key.normal < 0) key.normal = -2 - long(index / 3);
+
+						size_t slot = hashCorner(key) & (slotCount - 1);
+						while (slots[slot] != EMPTY_SLOT && !(vertexKeys[slots[slot]] == key)) slot = (slot + 1) & (slotCount - 1);
+
+						if (slots[slot] == EMPTY_SLOT) {
+							slots[slot] = (unsigned int)vertexCount;
+							vertexKeys[vertexCount] = key;
+							data.positions[vertexCount] = positions[corner.position];
+							data.UVs[vertexCount] = corner.uv >= 0 ? uvs[corner.uv] : glm::vec2(0.0f);
+							data.normals[vertexCount] = corner.normal >= 0 ? normals[corner.normal] : faceNormal;
+							vertexCount++;
+						}
+						data.indices[index++] = slots[slot];
+					}
+				}
+				previous = current;
+				corners++;
+			}
+		}
+
+		line = lineEnd < end ? lineEnd + 1 : end;
+	}
+
+	data.positions.resize(vertexCount);
+	data.positions.shrink_to_fit();
+	data.normals.resize(vertexCount);
+	data.normals.shrink_to_fit();
+	data.UVs.resize(vertexCount);
+	data.UVs.shrink_to_fit();
+
+	return true;
+}
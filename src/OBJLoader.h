@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include "Geometry.h"
+
+/*!
+ * Wavefront OBJ loader
+ * Parses the whole file from memory with a hand-written number scanner.
+ * A first pass counts all elements, so every output array is sized exactly once.
+ * Supports the face forms v, v/vt, v//vn and v/vt/vn, polygons with more than
+ * three corners (fan triangulated) and negative (relative) indices.
+ * Every distinct position/uv/normal combination becomes one vertex, the faces
+ * reference them through the index buffer.
+ */
+class OBJLoader
+{
+public:
+	/*!
+	 * Loads an OBJ file into geometry data
+	 * @param path: path to the OBJ file
+	 * @param data: the loaded, indexed geometry data
+	 * @return if the file could be loaded
+	 */
+	static bool load(const char* path, GeometryData& data);
+
+	/*!
+	 * Parses OBJ text that already is in memory
+	 * @param text: the OBJ text (does not have to be null terminated)
+	 * @param length: length of the text in bytes
+	 * @param data: the parsed, indexed geometry data
+	 * @return if the text could be parsed
+	 */
+	static bool parse(const char* text, size_t length, GeometryData& data);
+};
@@ -0,0 +1,158 @@
+#include "OcclusionBuffer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+/* --------------------------------------------- */
+// Occlusion buffer
+/* --------------------------------------------- */
+
+OcclusionBuffer::OcclusionBuffer(unsigned int width, unsigned int height)
+	: _width(width), _height(height), _viewProjection(1.0f)
+{
+	for (unsigned int level = 0; ; level++) {
+		unsigned int levelWidth = std::max(1u, width >> level), levelHeight = std::max(1u, height >> level);
+		_levels.push_back(std::vector<float>(size_t(levelWidth) * levelHeight, 1.0f));
+		if (levelWidth == 1 && levelHeight == 1) break;
+	}
+}
+
+void OcclusionBuffer::clear(const glm::mat4& viewProjection)
+{
+	_viewProjection = viewProjection;
+	std::fill(_levels[0].begin(), _levels[0].end(), 1.0f);
+}
+
+void OcclusionBuffer::rasterize(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices, const glm::mat4& modelMatrix)
+{
+	glm::mat4 modelViewProjection = _viewProjection * modelMatrix;
+	_clipPositions.resize(positions.size());
+	for (size_t i = 0; i < positions.size(); i++) _clipPositions[i] = modelViewProjection * glm::vec4(positions[i], 1.0f);
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		const glm::vec4* triangle[3] = { &_clipPositions[indices[i]], &_clipPositions[indices[i + 1]], &_clipPositions[indices[i + 2]] };
+		int inFront = 0;
+		for (const glm::vec4* v : triangle) inFront += v->z >= -v->w ? 1 : 0;
+		if (inFront == 0) continue;
+		if (inFront == 3) {
+			rasterizeTriangle(*triangle[0], *triangle[1], *triangle[2]);
+			continue;
+		}
+
+		// clip against the near plane (z = -w), which leaves a triangle or a quad in the same winding
+		glm::vec4 polygon[4];
+		int count = 0;
+		for (int v = 0; v < 3; v++) {
+			const glm::vec4& a = *triangle[v];
+			const glm::vec4& b = *triangle[(v + 1) % 3];
+			float da = a.z + a.w, db = b.z + b.w;
+			if (da >= 0.0f) polygon[count++] = a;
+			if ((da >= 0.0f) != (db >= 0.0f)) polygon[count++] = a + (b - a) * (da / (da - db));
+		}
+		for (int v = 1; v + 1 < count; v++) rasterizeTriangle(polygon[0], polygon[v], polygon[v + 1]);
+	}
+}
+
+void OcclusionBuffer::rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+	// window coordinates, z is the window depth
+	glm::vec3 s[3];
+	const glm::vec4* clip[3] = { &a, &b, &c };
+	for (int v = 0; v < 3; v++) {
+		glm::vec3 ndc = glm::vec3(*clip[v]) / clip[v]->w;
+		s[v] = glm::vec3((ndc.x * 0.5f + 0.5f) * float(_width), (ndc.y * 0.5f + 0.5f) * float(_height), ndc.z * 0.5f + 0.5f);
+	}
+	float area = (s[1].x - s[0].x) * (s[2].y - s[0].y) - (s[2].x - s[0].x) * (s[1].y - s[0].y);
+	if (!(area > 0.0f)) return;
+
+	// pixels whose centers lie in the bounding rectangle
+	float minX = std::min(s[0].x, std::min(s[1].x, s[2].x)), maxX = std::max(s[0].x, std::max(s[1].x, s[2].x));
+	float minY = std::min(s[0].y, std::min(s[1].y, s[2].y)), maxY = std::max(s[0].y, std::max(s[1].y, s[2].y));
+	int x0 = int(std::max(std::ceil(minX - 0.5f), 0.0f)), x1 = int(std::min(std::floor(maxX - 0.5f), float(_width) - 1.0f));
+	int y0 = int(std::max(std::ceil(minY - 0.5f), 0.0f)), y1 = int(std::min(std::floor(maxY - 0.5f), float(_height) - 1.0f));
+	if (x0 > x1 || y0 > y1) return;
+
+	// edge functions, positive inside a counter clockwise triangle, stepped per pixel
+	// edge e is opposite to vertex e, so the edge functions are the barycentric weights times the area
+	float stepX[3], stepY[3], row[3];
+	glm::vec2 p = glm::vec2(float(x0) + 0.5f, float(y0) + 0.5f);
+	for (int e = 0; e < 3; e++) {
+		const glm::vec3& from = s[(e + 1) % 3];
+		const glm::vec3& to = s[(e + 2) % 3];
+		stepX[e] = from.y - to.y;
+		stepY[e] = to.x - from.x;
+		row[e] = (to.x - from.x) * (p.y - from.y) - (to.y - from.y) * (p.x - from.x);
+	}
+	float inverseArea = 1.0f / area;
+	float depthX = (stepX[0] * s[0].z + stepX[1] * s[1].z + stepX[2] * s[2].z) * inverseArea;
+	float depthRow = (row[0] * s[0].z + row[1] * s[1].z + row[2] * s[2].z) * inverseArea;
+	float depthY = (stepY[0] * s[0].z + stepY[1] * s[1].z + stepY[2] * s[2].z) * inverseArea;
+
+	float* depthBuffer = _levels[0].data();
+	for (int y = y0; y <= y1; y++) {
+		float w0 = row[0], w1 = row[1], w2 = row[2], depth = depthRow;
+		float* pixel = depthBuffer + size_t(y) * _width;
+		for (int x = x0; x <= x1; x++) {
+			if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f && depth < pixel[x]) pixel[x] = depth;
+			w0 += stepX[0];
+			w1 += stepX[1];
+			w2 += stepX[2];
+			depth += depthX;
+		}
+		for (int e = 0; e < 3; e++) row[e] += stepY[e];
+		depthRow += depthY;
+	}
+}
+
+void OcclusionBuffer::buildHiZ()
+{
+	for (size_t level = 1; level < _levels.size(); level++) {
+		unsigned int sourceWidth = std::max(1u, _width >> (level - 1)), sourceHeight = std::max(1u, _height >> (level - 1));
+		unsigned int levelWidth = std::max(1u, _width >> level), levelHeight = std::max(1u, _height >> level);
+		const std::vector<float>& source = _levels[level - 1];
+		std::vector<float>& target = _levels[level];
+		for (unsigned int y = 0; y < levelHeight; y++) {
+			// a level of height 1 covers one row if the source has one row as well
+			const float* row0 = &source[size_t(std::min(2 * y, sourceHeight - 1)) * sourceWidth];
+			const float* row1 = &source[size_t(std::min(2 * y + 1, sourceHeight - 1)) * sourceWidth];
+			for (unsigned int x = 0; x < levelWidth; x++) {
+				unsigned int sx0 = std::min(2 * x, sourceWidth - 1), sx1 = std::min(2 * x + 1, sourceWidth - 1);
+				target[size_t(y) * levelWidth + x] = std::max(std::max(row0[sx0], row0[sx1]), std::max(row1[sx0], row1[sx1]));
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::isVisible(const glm::vec3& min, const glm::vec3& max) const
+{
+	// screen rectangle and nearest depth of the corners
+	glm::vec2 rectMin = glm::vec2(FLT_MAX), rectMax = glm::vec2(-FLT_MAX);
+	float nearestDepth = FLT_MAX;
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec4 clip = _viewProjection * glm::vec4(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z, 1.0f);
+		if (clip.w <= 0.0f || clip.z < -clip.w) return true;
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		rectMin = glm::min(rectMin, glm::vec2(ndc));
+		rectMax = glm::max(rectMax, glm::vec2(ndc));
+		nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+	}
+	if (rectMax.x < -1.0f || rectMin.x > 1.0f || rectMax.y < -1.0f || rectMin.y > 1.0f) return true;
+
+	// the level where the rectangle spans at most two texels in each direction
+	glm::vec2 size = glm::vec2(float(_width), float(_height));
+	glm::vec2 pixelMin = (glm::clamp(rectMin, -1.0f, 1.0f) * 0.5f + 0.5f) * size;
+	glm::vec2 pixelMax = (glm::clamp(rectMax, -1.0f, 1.0f) * 0.5f + 0.5f) * size;
+	float extent = std::max(pixelMax.x - pixelMin.x, pixelMax.y - pixelMin.y);
+	unsigned int level = extent > 1.0f ? unsigned(std::ceil(std::log2(extent))) : 0;
+	level = std::min(level, unsigned(_levels.size()) - 1);
+
+	unsigned int levelWidth = std::max(1u, _width >> level), levelHeight = std::max(1u, _height >> level);
+	unsigned int x0 = std::min(unsigned(pixelMin.x) >> level, levelWidth - 1), x1 = std::min(unsigned(pixelMax.x) >> level, levelWidth - 1);
+	unsigned int y0 = std::min(unsigned(pixelMin.y) >> level, levelHeight - 1), y1 = std::min(unsigned(pixelMax.y) >> level, levelHeight - 1);
+	const std::vector<float>& depths = _levels[level];
+	float farthest = 0.0f;
+	for (unsigned int y = y0; y <= y1; y++) {
+		for (unsigned int x = x0; x <= x1; x++) farthest = std::max(farthest, depths[size_t(y) * levelWidth + x]);
+	}
+	return nearestDepth <= farthest;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+
+/*!
+ * Software rasterized depth buffer of the large occluders of a frame, with a hierarchical-Z pyramid to test boxes against
+ * Depths are window depths in [0, 1] like gl_FragCoord.z, row 0 is the bottom of the screen.
+ * Every pyramid level stores the farthest depth of the 2x2 texels below it, so a box whose nearest point is behind
+ * the stored depth of all texels it covers is hidden. The test is conservative: a box is only reported as hidden if it
+ * is behind the occluders at every pixel center it covers.
+ * This is the CPU version of HiZCuller (and of hiz_test.comp), it runs without a GPU and is what --benchmark tests.
+ */
+class OcclusionBuffer
+{
+protected:
+	unsigned int _width, _height;
+	/*!
+	 * Level 0 is the depth buffer, every further level halves the size down to 1x1
+	 */
+	std::vector<std::vector<float>> _levels;
+	glm::mat4 _viewProjection;
+	/*!
+	 * Clip space positions of the occluder being rasterized, kept for the next occluder
+	 */
+	std::vector<glm::vec4> _clipPositions;
+
+	/*!
+	 * Rasterizes a triangle in front of the near plane with back face culling
+	 * @param a, b, c: clip space positions with w > 0
+	 */
+	void rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+
+public:
+	/*!
+	 * @param width: width of the depth buffer, a power of two
+	 * @param height: height of the depth buffer, a power of two
+	 */
+	OcclusionBuffer(unsigned int width = 256, unsigned int height = 128);
+
+	/*!
+	 * Clears the depth buffer to the far plane for a new frame
+	 * @param viewProjection: the view-projection matrix of the frame
+	 */
+	void clear(const glm::mat4& viewProjection);
+	/*!
+	 * Rasterizes the front faces of an occluder into the depth buffer
+	 * The occluder must not be larger than the object it stands for, e.g. a low polygon version with vertices on its surface.
+	 * @param positions: vertex positions of the occluder
+	 * @param indices: triangle list, counter clockwise front faces
+	 * @param modelMatrix: model matrix of the occluder
+	 */
+	void rasterize(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices, const glm::mat4& modelMatrix);
+	/*!
+	 * Builds the pyramid levels from the depth buffer, has to be called after the last occluder
+	 */
+	void buildHiZ();
+
+	/*!
+	 * Tests a box against the pyramid, at a level where the box covers at most 2x2 texels
+	 * Boxes that reach in front of the near plane or lie outside the screen are visible, frustum culling decides about them.
+	 * @param min: minimum corner of the box in world space
+	 * @param max: maximum corner of the box in world space
+	 * @return if the box may be visible
+	 */
+	bool isVisible(const glm::vec3& min, const glm::vec3& max) const;
+
+	/*!
+	 * @return the depth of a pixel after rasterization (level 0)
+	 */
+	float getDepth(unsigned int x, unsigned int y) const { return _levels[0][y * _width + x]; }
+	unsigned int getWidth() const { return _width; }
+	unsigned int getHeight() const { return _height; }
+	/*!
+	 * @return the number of pyramid levels, including the depth buffer
+	 */
+	unsigned int getLevelCount() const { return unsigned(_levels.size()); }
+};
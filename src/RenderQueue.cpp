@@ -0,0 +1,242 @@
+#include "RenderQueue.h"
+#include <algorithm>
+#include <cstring>
+#include "GLState.h"
+
+static const UniformId MODEL_MATRIX("modelMatrix");
+static const UniformId NORMAL_MATRIX("normalMatrix");
+static const UniformId INSTANCED("instanced");
+
+/*!
+ * Categories of the interned ids
+ */
+enum IdCategory {
+	SHADER_IDS,
+	TEXTURE_IDS,
+	MATERIAL_IDS,
+	MESH_IDS
+};
+
+/*!
+ * @return the value clamped to a field of the given number of bits
+ */
+static uint64_t field(uint64_t value, unsigned int bits)
+{
+	return std::min<uint64_t>(value, (uint64_t(1) << bits) - 1);
+}
+
+RenderQueue::RenderQueue(bool instancing)
+	: _instancing(instancing), _cameraPosition(0.0f), _farZ(1.0f), _instanceBuffer(0), _instanceCapacity(0), _instancesUploaded(false)
+{
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+RenderQueue::~RenderQueue()
+{
+	if (_instanceBuffer != 0) GLState::deleteBuffers(1, &_instanceBuffer);
+}
+
+uint32_t RenderQueue::id(unsigned int category, const void* object)
+{
+	if (object == nullptr) return 0;
+	std::unordered_map<const void*, uint32_t>& ids = _ids[category];
+	auto it = ids.find(object);
+	if (it != ids.end()) return it->second;
+	uint32_t newId = uint32_t(ids.size()) + 1;
+	ids[object] = newId;
+	return newId;
+}
+
+uint64_t RenderQueue::makeKey(unsigned int pass, uint32_t shader, uint32_t texture, uint32_t material, uint32_t mesh, float depth)
+{
+	uint64_t depthBits = uint64_t(glm::clamp(depth, 0.0f, 1.0f) * float((1 << 14) - 1));
+	return field(pass, 4) << 60 | field(shader, 8) << 52 | field(texture, 12) << 40 | field(material, 12) << 28 | field(mesh, 14) << 14 | depthBits;
+}
+
+void RenderQueue::begin(const glm::vec3& cameraPosition, float farZ)
+{
+	_items.clear();
+	_cameraPosition = cameraPosition;
+	_farZ = farZ;
+}
+
+void RenderQueue::submit(const Geometry& geometry, unsigned int pass)
+{
+	Material* material = geometry.getMaterial().get();
+	RenderItem item;
+	item.shader = id(SHADER_IDS, material->getShader());
+	item.texture = id(TEXTURE_IDS, material->getTexture());
+	item.material = id(MATERIAL_IDS, material);
+	item.mesh = id(MESH_IDS, geometry.getMesh().get());
+	item.geometry = &geometry;
+
+	float depth = glm::length(glm::vec3(geometry.getModelMatrix()[3]) - _cameraPosition) / _farZ;
+	item.key = makeKey(pass, item.shader, item.texture, item.material, item.mesh, depth);
+	_items.push_back(item);
+}
+
+void RenderQueue::submit(const RenderItem& item)
+{
+	_items.push_back(item);
+}
+
+void RenderQueue::sort()
+{
+	std::sort(_items.begin(), _items.end(), [](const RenderItem& a, const RenderItem& b) { return a.key < b.key; });
+}
+
+const std::vector<RenderCommand>& RenderQueue::record()
+{
+	_commands.clear();
+	_instancesUploaded = false;
+	memset(&_stats, 0, sizeof(_stats));
+	_stats.objects = _items.size();
+
+	// the state is unknown at the start of the frame, e.g. the text overlay binds other programs and textures
+	uint32_t shader = 0, texture = 0, material = 0, mesh = 0;
+	bool first = true;
+	for (uint32_t i = 0; i < _items.size(); i++) {
+		const RenderItem& item = _items[i];
+		if (first || item.shader != shader) {
+			_commands.push_back({ RenderCommandType::USE_PROGRAM, i, 0 });
+			_stats.programChanges++;
+			shader = item.shader;
+			// uniforms belong to the program
+			material = 0;
+			mesh = 0;
+		}
+		if (item.texture != 0 && (first || item.texture != texture)) {
+			_commands.push_back({ RenderCommandType::BIND_TEXTURE, i, 0 });
+			_stats.textureBinds++;
+			texture = item.texture;
+		}
+		if (item.material != material) {
+			_commands.push_back({ RenderCommandType::SET_MATERIAL, i, 0 });
+			_stats.materialChanges++;
+			material = item.material;
+		}
+		if (item.mesh != mesh) {
+			_commands.push_back({ RenderCommandType::BIND_MESH, i, 0 });
+			_stats.meshBinds++;
+			mesh = item.mesh;
+		}
+		first = false;
+
+		// all following items with the same material and mesh need no state change
+		uint32_t count = 1;
+		while (i + count < _items.size() && _items[i + count].shader == shader && _items[i + count].material == material && _items[i + count].mesh == mesh) count++;
+		if (_instancing && count > 1) {
+			_commands.push_back({ RenderCommandType::DRAW_INSTANCED, i, count });
+			_stats.drawCalls++;
+		}
+		else {
+			for (uint32_t j = 0; j < count; j++) _commands.push_back({ RenderCommandType::DRAW, i + j, 1 });
+			_stats.drawCalls += count;
+		}
+		i += count - 1;
+	}
+	return _commands;
+}
+
+void RenderQueue::uploadInstances()
+{
+	if (_instancesUploaded) return;
+	_instancesUploaded = true;
+
+	// upload the instances of all instanced draws at once, the buffer is orphaned so that the driver does not wait for the last frame
+	_instances.clear();
+	for (const RenderCommand& command : _commands) {
+		if (command.type != RenderCommandType::DRAW_INSTANCED) continue;
+		for (uint32_t i = command.item; i < command.item + command.count; i++) {
+			InstanceData instance;
+			instance.modelMatrix = _items[i].geometry->getModelMatrix();
+			instance.normalMatrix = _items[i].geometry->getNormalMatrix();
+			_instances.push_back(instance);
+		}
+	}
+	if (!_instances.empty()) {
+		if (_instanceBuffer == 0) glGenBuffers(1, &_instanceBuffer);
+		_instanceCapacity = std::max(_instanceCapacity, _instances.size());
+		GLState::bindBuffer(GL_ARRAY_BUFFER, _instanceBuffer);
+		glBufferData(GL_ARRAY_BUFFER, _instanceCapacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, _instances.size() * sizeof(InstanceData), _instances.data());
+		GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+void RenderQueue::executeDepth(Shader* depthShader)
+{
+	uploadInstances();
+
+	// one program for all items, only meshes are bound and only the positions are read
+	size_t instanceOffset = 0;
+	GLState::useProgram(depthShader->getHandle());
+	for (const RenderCommand& command : _commands) {
+		const Geometry& geometry = *_items[command.item].geometry;
+		switch (command.type) {
+		case RenderCommandType::BIND_MESH:
+			geometry.getMesh()->bind();
+			geometry.getMesh()->setUniforms(depthShader);
+			break;
+		case RenderCommandType::DRAW:
+			depthShader->setUniform(MODEL_MATRIX, geometry.getModelMatrix());
+			depthShader->setUniform(INSTANCED, 0);
+			geometry.getMesh()->drawElements();
+			break;
+		case RenderCommandType::DRAW_INSTANCED:
+			depthShader->setUniform(INSTANCED, 1);
+			geometry.getMesh()->drawElementsInstanced(_instanceBuffer, GLintptr(instanceOffset * sizeof(InstanceData)), GLsizei(command.count));
+			instanceOffset += command.count;
+			break;
+		default:
+			break;
+		}
+	}
+	GLState::bindVertexArray(0);
+}
+
+void RenderQueue::execute()
+{
+	uploadInstances();
+
+	size_t instanceOffset = 0;
+	Shader* shader = nullptr;
+	for (const RenderCommand& command : _commands) {
+		const Geometry& geometry = *_items[command.item].geometry;
+		switch (command.type) {
+		case RenderCommandType::USE_PROGRAM:
+			shader = geometry.getMaterial()->getShader();
+			GLState::useProgram(shader->getHandle());
+			break;
+		case RenderCommandType::BIND_TEXTURE:
+			geometry.getMaterial()->bindTextures();
+			break;
+		case RenderCommandType::SET_MATERIAL:
+			geometry.getMaterial()->setUniforms();
+			break;
+		case RenderCommandType::BIND_MESH:
+			geometry.getMesh()->bind();
+			geometry.getMesh()->setUniforms(shader);
+			break;
+		case RenderCommandType::DRAW:
+			shader->setUniform(MODEL_MATRIX, geometry.getModelMatrix());
+			shader->setUniform(NORMAL_MATRIX, geometry.getNormalMatrix());
+			shader->setUniform(INSTANCED, 0);
+			geometry.getMesh()->drawElements();
+			break;
+		case RenderCommandType::DRAW_INSTANCED:
+			shader->setUniform(INSTANCED, 1);
+			geometry.getMesh()->drawElementsInstanced(_instanceBuffer, GLintptr(instanceOffset * sizeof(InstanceData)), GLsizei(command.count));
+			instanceOffset += command.count;
+			break;
+		}
+	}
+	GLState::bindVertexArray(0);
+}
+
+void RenderQueue::flush()
+{
+	sort();
+	record();
+	execute();
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <GL\glew.h>
+#include <glm\glm.hpp>
+#include "Geometry.h"
+#include "Mesh.h"
+
+/*!
+ * One object in the render queue
+ * The state is identified by small interned ids (0 = none), the key sorts the items by state.
+ */
+struct RenderItem {
+	uint64_t key;
+	uint32_t shader;
+	uint32_t texture;
+	uint32_t material;
+	uint32_t mesh;
+	/*!
+	 * The object to draw, only used when executing
+	 */
+	const Geometry* geometry;
+};
+
+enum class RenderCommandType {
+	USE_PROGRAM,
+	SET_MATERIAL,
+	BIND_TEXTURE,
+	BIND_MESH,
+	DRAW,
+	DRAW_INSTANCED
+};
+
+/*!
+ * One entry of the recorded command stream
+ * State commands refer to the item whose state is set, draws to the first item and the number of items.
+ */
+struct RenderCommand {
+	RenderCommandType type;
+	uint32_t item;
+	uint32_t count;
+};
+
+/*!
+ * Number of objects, draw calls and state changes of the last recorded frame
+ * Without the queue every object costs one of each.
+ */
+struct RenderQueueStats {
+	size_t objects;
+	size_t drawCalls;
+	size_t programChanges;
+	size_t materialChanges;
+	size_t textureBinds;
+	size_t meshBinds;
+};
+
+/*!
+ * Collects the objects of a frame, sorts them by state and draws them with as few state changes as possible
+ * The 64-bit sort key holds, from the most significant bits: pass, shader, texture, material, mesh and depth.
+ * The texture ranks above the material, a material always binds the same texture.
+ * Recording the command stream only compares ids, so it needs no OpenGL context and can be tested headless.
+ * Uniforms are per program, so a program change sets the material and mesh uniforms again.
+ */
+class RenderQueue
+{
+protected:
+	/*!
+	 * If runs of objects with the same material and mesh are drawn with one instanced draw call
+	 */
+	bool _instancing;
+
+	std::vector<RenderItem> _items;
+	std::vector<RenderCommand> _commands;
+	RenderQueueStats _stats;
+
+	/*!
+	 * Interned ids by object address, kept over frames so that keys are stable
+	 */
+	std::unordered_map<const void*, uint32_t> _ids[4];
+
+	/*!
+	 * Camera of the frame, for the depth part of the key
+	 */
+	glm::vec3 _cameraPosition;
+	float _farZ;
+
+	/*!
+	 * Per-instance data of the instanced draws of the frame, uploaded at once
+	 */
+	std::vector<InstanceData> _instances;
+	GLuint _instanceBuffer;
+	size_t _instanceCapacity;
+	/*!
+	 * If the instances of the recorded commands are in the buffer, the depth pre-pass and the shading pass share them
+	 */
+	bool _instancesUploaded;
+
+	/*!
+	 * @return the interned id of an object, 0 for nullptr
+	 */
+	uint32_t id(unsigned int category, const void* object);
+	/*!
+	 * Uploads the per-instance data of all instanced draws of the recorded commands, once per recording
+	 */
+	void uploadInstances();
+
+public:
+	/*!
+	 * @param instancing: if runs of objects with the same material and mesh are drawn with one instanced draw call
+	 */
+	RenderQueue(bool instancing);
+	~RenderQueue();
+
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+
+	/*!
+	 * Packs the state of an object into a sort key, fields that do not fit are clamped
+	 * @param pass: render pass (4 bits), drawn in ascending order
+	 * @param shader: shader id (8 bits)
+	 * @param texture: texture id (12 bits)
+	 * @param material: material id (12 bits)
+	 * @param mesh: mesh id (14 bits)
+	 * @param depth: distance to the camera relative to the far plane, 0 to 1 (14 bits), near objects first
+	 * @return the sort key
+	 */
+	static uint64_t makeKey(unsigned int pass, uint32_t shader, uint32_t texture, uint32_t material, uint32_t mesh, float depth);
+
+	/*!
+	 * Starts a new frame and removes all objects
+	 * @param cameraPosition: position of the camera, objects are sorted front to back within their state
+	 * @param farZ: far plane distance
+	 */
+	void begin(const glm::vec3& cameraPosition, float farZ);
+
+	/*!
+	 * Adds an object to the frame
+	 * @param geometry: the object, has to live until the queue is executed
+	 * @param pass: render pass, lower passes are drawn first
+	 */
+	void submit(const Geometry& geometry, unsigned int pass = 0);
+	/*!
+	 * Adds an item with explicit ids and key, e.g. to record a synthetic frame
+	 * @param item: the item
+	 */
+	void submit(const RenderItem& item);
+
+	/*!
+	 * Sorts the items by key
+	 */
+	void sort();
+
+	/*!
+	 * Records the command stream of the sorted items, skipping redundant state changes, and updates the statistics
+	 * @return the command stream
+	 */
+	const std::vector<RenderCommand>& record();
+
+	/*!
+	 * Issues the recorded command stream
+	 */
+	void execute();
+	/*!
+	 * Issues the draws of the recorded command stream with one depth-only program, e.g. for a depth pre-pass
+	 * Program, texture and material changes are skipped, the meshes are bound in the same order as by execute().
+	 * @param depthShader: program that only transforms the positions, it is given the mesh and model matrix uniforms
+	 */
+	void executeDepth(Shader* depthShader);
+
+	/*!
+	 * Sorts, records and executes the frame
+	 */
+	void flush();
+
+	/*!
+	 * @return the sorted items, the commands refer to them by index
+	 */
+	const std::vector<RenderItem>& getItems() const { return _items; }
+	/*!
+	 * @return the statistics of the last recorded frame
+	 */
+	const RenderQueueStats& getStats() const { return _stats; }
+};
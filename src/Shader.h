@@ -7,6 +7,7 @@
 
 #include <GL\glew.h>
 #include <string>
+#include <memory>
 #include <fstream>
 #include <iostream>
 #include <unordered_map>
@@ -14,6 +15,7 @@
 #include <glm\gtc\type_ptr.hpp>
 
 #include "Utils.h"
+#include "UniformId.h"
 
 
 /*!
@@ -83,6 +85,21 @@ public:
 	
 	~Shader();
 
+	/*!
+	 * Creates a shader whose cached uniform locations are dropped when it is deleted
+	 * The destructor is part of the framework library, OpenGL may give its program handle to a later program.
+	 * @param vs: path to the vertex shader
+	 * @param fs: path to the fragment shader
+	 * @return the shader
+	 */
+	static std::shared_ptr<Shader> create(std::string vs, std::string fs)
+	{
+		return std::shared_ptr<Shader>(new Shader(vs, fs), [](Shader* shader) {
+			UniformId::forget(shader->getHandle());
+			delete shader;
+		});
+	}
+
 	/*!
 	 * Uses the shader with glUseProgram
 	 */
@@ -189,6 +206,13 @@ public:
 	 * @param vec: the value to be set
 	 */
 	void setUniform(GLint location, const glm::vec4& vec);
+	/*!
+	 * Sets a uniform in the shader through its interned id, without allocating or hashing the name
+	 * @param uniform: the interned uniform, e.g. a static constant of the caller
+	 * @param value: the value to be set, any type of the location overloads
+	 */
+	template<typename T>
+	void setUniform(const UniformId& uniform, const T& value) { setUniform(uniform.getLocation(_handle), value); }
 	/*!
 	 * Sets a uniform array property
 	 * @param arr: name of the uniform array
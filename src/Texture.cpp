@@ -0,0 +1,174 @@
+/*
+* Copyright 2018 Vienna University of Technology.
+* Institute of Computer Graphics and Algorithms.
+* This file is part of the ECG Lab Framework and must not be redistributed.
+*/
+#include "Texture.h"
+#include <algorithm>
+#include <memory>
+#include "DDSFile.h"
+#include "GLState.h"
+
+TextureStats Texture::_stats = { 0, 0 };
+
+/* --------------------------------------------- */
+// Helpers
+/* --------------------------------------------- */
+
+/*!
+ * Uploads all stored mip levels of one face of a DDS file
+ * @param target: GL_TEXTURE_2D or the cubemap face target
+ * @param file: the DDS file
+ * @param face: the face of the file to upload
+ */
+static void uploadLevels(GLenum target, const DDSFile& file, unsigned int face)
+{
+	for (unsigned int level = 0; level < file.getMipLevels(); level++) {
+		const DDSLevel& l = file.getLevel(face, level);
+		glCompressedTexSubImage2D(target, level, 0, 0, l.width, l.height, file.getFormat(), GLsizei(l.size), file.getLevelData(face, level));
+	}
+}
+
+/* --------------------------------------------- */
+// Texture
+/* --------------------------------------------- */
+
+Texture::Texture()
+	: _handle(0), _target(GL_TEXTURE_2D), _init(false)
+{
+	const unsigned char white[4] = { 255, 255, 255, 255 };
+	glGenTextures(1, &_handle);
+	GLState::bindTexture(_target, _handle);
+	glTexStorage2D(_target, 1, GL_RGBA8, 1, 1);
+	glTexSubImage2D(_target, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+	setParameters(1);
+}
+
+Texture::Texture(std::string file)
+	: _handle(0), _target(GL_TEXTURE_2D), _init(false)
+{
+	std::string path = "assets/textures/" + file;
+	DDSFile dds(path);
+	_stats.fileReads++;
+	if (!dds.isValid()) return;
+
+	// immutable storage with exactly the mip levels stored in the file
+	_target = dds.isCubemap() ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+	glGenTextures(1, &_handle);
+	GLState::bindTexture(_target, _handle);
+	glTexStorage2D(_target, dds.getMipLevels(), dds.getFormat(), dds.getWidth(), dds.getHeight());
+	for (unsigned int face = 0; face < dds.getFaces(); face++) {
+		uploadLevels(dds.isCubemap() ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D, dds, face);
+	}
+	_stats.uploads++;
+
+	setParameters(dds.getMipLevels());
+	_init = true;
+}
+
+Texture::Texture(const std::vector<std::string>& faceFiles)
+	: _handle(0), _target(GL_TEXTURE_CUBE_MAP), _init(false)
+{
+	if (faceFiles.size() != 6) {
+		std::cout << "ERROR: A cubemap needs six face files" << std::endl;
+		return;
+	}
+
+	glGenTextures(1, &_handle);
+	GLState::bindTexture(_target, _handle);
+	for (unsigned int face = 0; face < 6; face++) {
+		std::string path = "assets/textures/" + faceFiles[face];
+		DDSFile dds(path);
+		_stats.fileReads++;
+		if (!dds.isValid()) {
+			GLState::deleteTextures(1, &_handle);
+			_handle = 0;
+			return;
+		}
+		// the first face defines the storage, all others have to match it
+		if (face == 0) glTexStorage2D(_target, dds.getMipLevels(), dds.getFormat(), dds.getWidth(), dds.getHeight());
+		uploadLevels(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, dds, 0);
+		if (face == 5) setParameters(dds.getMipLevels());
+	}
+	_stats.uploads++;
+	_init = true;
+}
+
+Texture::~Texture()
+{
+	GLState::deleteTextures(1, &_handle);
+}
+
+void Texture::resolve(GLuint handle, GLenum target, unsigned int mipLevels)
+{
+	GLState::deleteTextures(1, &_handle);
+	_handle = handle;
+	_target = target;
+	GLState::bindTexture(_target, _handle);
+	setParameters(mipLevels);
+	_stats.fileReads++;
+	_stats.uploads++;
+	_init = true;
+}
+
+void Texture::setParameters(unsigned int mipLevels)
+{
+	glTexParameteri(_target, GL_TEXTURE_MIN_FILTER, mipLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	if (_target == GL_TEXTURE_CUBE_MAP) {
+		glTexParameteri(_target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(_target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(_target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	}
+	else {
+		glTexParameteri(_target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(_target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	}
+	GLState::bindTexture(_target, 0);
+}
+
+void Texture::bind(unsigned int unit)
+{
+	GLState::bindTexture(unit, _target, _handle);
+}
+
+/* --------------------------------------------- */
+// Texture array
+/* --------------------------------------------- */
+
+TextureArray::TextureArray(const std::vector<std::string>& layerFiles)
+	: Texture()
+{
+	std::vector<std::unique_ptr<DDSFile>> files;
+	unsigned int mipLevels = 0;
+	for (const std::string& file : layerFiles) {
+		files.push_back(std::unique_ptr<DDSFile>(new DDSFile("assets/textures/" + file)));
+		_stats.fileReads++;
+		const DDSFile& dds = *files.back();
+		if (!dds.isValid()) return;
+		if (dds.isCubemap() || dds.getFormat() != files[0]->getFormat() || dds.getWidth() != files[0]->getWidth() || dds.getHeight() != files[0]->getHeight()
+			|| dds.getMipLevels() != files[0]->getMipLevels()) {
+			std::cout << "ERROR: " << file << " does not match the format, size and mip levels of the other layers" << std::endl;
+			return;
+		}
+		mipLevels = dds.getMipLevels();
+	}
+	if (files.empty()) return;
+
+	// replace the placeholder
+	GLState::deleteTextures(1, &_handle);
+	_target = GL_TEXTURE_2D_ARRAY;
+	glGenTextures(1, &_handle);
+	GLState::bindTexture(_target, _handle);
+	glTexStorage3D(_target, mipLevels, files[0]->getFormat(), files[0]->getWidth(), files[0]->getHeight(), GLsizei(files.size()));
+	for (unsigned int layer = 0; layer < files.size(); layer++) {
+		for (unsigned int level = 0; level < mipLevels; level++) {
+			const DDSLevel& l = files[layer]->getLevel(0, level);
+			glCompressedTexSubImage3D(_target, level, 0, 0, layer, l.width, l.height, 1, files[layer]->getFormat(), GLsizei(l.size), files[layer]->getLevelData(0, level));
+		}
+	}
+	_stats.uploads++;
+
+	setParameters(mipLevels);
+	_init = true;
+}
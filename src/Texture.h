@@ -7,29 +7,108 @@
 
 
 #include <string>
+#include <vector>
 #include <GL/glew.h>
 #include "Utils.h"
 
 /*!
- * 2D texture
+ * Counts how often texture files are read and texture data is uploaded
+ */
+struct TextureStats {
+	/*!
+	 * Number of texture files read from disk
+	 */
+	size_t fileReads;
+	/*!
+	 * Number of texture images uploaded to the GPU
+	 */
+	size_t uploads;
+};
+
+/*!
+ * 2D texture or cubemap
+ * The DDS file is loaded once in the constructor into immutable storage, with all mip levels stored in the file.
  */
 class Texture
 {
 protected:
 	GLuint _handle;
+	/*!
+	 * GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D_ARRAY
+	 */
+	GLenum _target;
 	bool _init;
 
+	/*!
+	 * Counters of all textures
+	 */
+	static TextureStats _stats;
+
+	/*!
+	 * Sets the filter and wrap modes and unbinds the texture
+	 * @param mipLevels: number of mip levels of the texture
+	 */
+	void setParameters(unsigned int mipLevels);
+
 public:
+	/*!
+	 * Creates a 1x1 white placeholder texture, replaced with resolve() once the real texture is uploaded
+	 */
+	Texture();
 	/*!
 	 * Creates a texture from a file
-	 * @param file: path to the texture file (a DSS image)
+	 * @param file: path to the texture file (a DDS image, a cubemap if the file contains all six faces)
 	 */
 	Texture(std::string file);
+	/*!
+	 * Creates a cubemap from one file per face
+	 * @param faceFiles: paths to the six DDS files in the order +X, -X, +Y, -Y, +Z, -Z
+	 */
+	Texture(const std::vector<std::string>& faceFiles);
 	~Texture();
 
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
 	/*!
 	 * Activates the texture unit and binds this texture
 	 * @param unit: the texture unit
 	 */
 	void bind(unsigned int unit);
+
+	/*!
+	 * @return GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D_ARRAY
+	 */
+	GLenum getTarget() const { return _target; }
+
+	/*!
+	 * Replaces the placeholder with a completely uploaded texture
+	 * @param handle: the new texture, this object takes ownership
+	 * @param target: GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D_ARRAY
+	 * @param mipLevels: number of mip levels of the new texture
+	 */
+	void resolve(GLuint handle, GLenum target, unsigned int mipLevels);
+	/*!
+	 * @return if the texture is still the placeholder
+	 */
+	bool isPlaceholder() const { return !_init; }
+
+	/*!
+	 * @return the file read and upload counters of all textures
+	 */
+	static const TextureStats& getStats() { return _stats; }
+};
+
+/*!
+ * 2D array texture with one DDS file per layer
+ * All files need the same format, size and number of mip levels.
+ */
+class TextureArray : public Texture
+{
+public:
+	/*!
+	 * Creates an array texture from files
+	 * @param layerFiles: paths to the DDS files of the layers, relative to assets/textures
+	 */
+	TextureArray(const std::vector<std::string>& layerFiles);
 };
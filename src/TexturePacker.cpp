@@ -0,0 +1,56 @@
+#include "TexturePacker.h"
+#include "DDSFile.h"
+
+TexturePacker::TexturePacker(bool enabled)
+	: _enabled(enabled), _textureCount(0)
+{
+}
+
+void TexturePacker::add(const std::string& file)
+{
+	if (_layers.find(file) != _layers.end()) return;
+	_layers[file] = { nullptr, 0 };
+	_files.push_back(file);
+}
+
+void TexturePacker::pack(AssetLoader* loader)
+{
+	// group by format, size and mip levels in the order the files were added, cubemaps and invalid files are never packed
+	// (an array has one mip count, so a texture with another one would lose levels or sample missing ones)
+	std::map<std::tuple<GLenum, unsigned int, unsigned int, unsigned int>, std::vector<std::string>> groups;
+	std::vector<std::string> singles;
+	for (const std::string& file : _files) {
+		if (!_enabled) {
+			singles.push_back(file);
+			continue;
+		}
+		DDSFile dds("assets/textures/" + file);
+		if (!dds.isValid() || dds.isCubemap()) singles.push_back(file);
+		else groups[std::make_tuple(dds.getFormat(), dds.getWidth(), dds.getHeight(), dds.getMipLevels())].push_back(file);
+	}
+	for (auto& group : groups) {
+		if (group.second.size() == 1) singles.push_back(group.second[0]);
+	}
+
+	for (auto& group : groups) {
+		const std::vector<std::string>& files = group.second;
+		if (files.size() < 2) continue;
+		std::shared_ptr<Texture> texture = loader != nullptr ? loader->loadTextureArray(files) : std::make_shared<TextureArray>(files);
+		for (size_t i = 0; i < files.size(); i++) _layers[files[i]] = { texture, int(i) };
+		_textureCount++;
+	}
+	for (const std::string& file : singles) {
+		_layers[file] = { loader != nullptr ? loader->loadTexture(file) : std::make_shared<Texture>(file), 0 };
+		_textureCount++;
+	}
+}
+
+TextureLayer TexturePacker::get(const std::string& file) const
+{
+	auto it = _layers.find(file);
+	if (it == _layers.end() || it->second.texture == nullptr) {
+		std::cout << "ERROR: Texture " << file << " was not packed" << std::endl;
+		return { nullptr, 0 };
+	}
+	return it->second;
+}
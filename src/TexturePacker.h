@@ -0,0 +1,78 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <GL\glew.h>
+#include "Texture.h"
+#include "AssetLoader.h"
+
+/*!
+ * A texture and the layer to sample if it is an array texture
+ */
+struct TextureLayer {
+	std::shared_ptr<Texture> texture;
+	int layer;
+};
+
+/*!
+ * Packs DDS textures with the same format, size and number of mip levels into array textures at load time
+ * Materials reference a layer of a shared array texture, so consecutive draws with different
+ * textures of one array need no texture bind. Textures without a partner stay 2D textures.
+ */
+class TexturePacker
+{
+protected:
+	/*!
+	 * If textures are packed, otherwise every file becomes its own 2D texture
+	 */
+	bool _enabled;
+	/*!
+	 * Added files in order
+	 */
+	std::vector<std::string> _files;
+	/*!
+	 * Packed textures by file
+	 */
+	std::map<std::string, TextureLayer> _layers;
+	/*!
+	 * Number of texture objects created by pack()
+	 */
+	size_t _textureCount;
+
+public:
+	/*!
+	 * @param enabled: if textures are packed into arrays
+	 */
+	TexturePacker(bool enabled);
+
+	/*!
+	 * Adds a texture to be packed
+	 * @param file: path to the DDS file relative to assets/textures
+	 */
+	void add(const std::string& file);
+
+	/*!
+	 * Reads the headers of all added files, groups them by format, size and mip levels and creates the textures
+	 * The group key is read from the headers only, the texture data is uploaded by the loader if set.
+	 * @param loader: loads the textures in the background if set
+	 */
+	void pack(AssetLoader* loader = nullptr);
+
+	/*!
+	 * @param file: an added file
+	 * @return the texture of the file and its layer (0 for 2D textures)
+	 */
+	TextureLayer get(const std::string& file) const;
+
+	/*!
+	 * @return the number of added files
+	 */
+	size_t getFileCount() const { return _files.size(); }
+	/*!
+	 * @return the number of texture objects the files were packed into
+	 */
+	size_t getTextureCount() const { return _textureCount; }
+};
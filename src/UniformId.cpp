@@ -0,0 +1,54 @@
+#include "UniformId.h"
+
+/*!
+ * Location of uniforms that were not queried yet (-1 is a valid result for inactive uniforms)
+ */
+static const GLint UNRESOLVED = -2;
+
+std::vector<std::string>& UniformId::names()
+{
+	// function statics, so ids can be static constants in any translation unit
+	static std::vector<std::string> names;
+	return names;
+}
+
+std::vector<std::vector<GLint>>& UniformId::locations()
+{
+	static std::vector<std::vector<GLint>> locations;
+	return locations;
+}
+
+UniformId::UniformId(const char* name)
+	: _index(0)
+{
+	// ids are created once, a linear search is fast enough
+	std::vector<std::string>& interned = names();
+	while (_index < interned.size() && interned[_index] != name) _index++;
+	if (_index == interned.size()) interned.push_back(name);
+}
+
+const std::string& UniformId::getName() const
+{
+	return names()[_index];
+}
+
+GLint UniformId::getLocation(GLuint program) const
+{
+	std::vector<std::vector<GLint>>& programs = locations();
+	if (program >= programs.size()) programs.resize(program + 1);
+
+	// only grows when ids were interned after the program was first used
+	std::vector<GLint>& programLocations = programs[program];
+	if (_index >= programLocations.size()) programLocations.resize(names().size(), UNRESOLVED);
+
+	GLint& location = programLocations[_index];
+	if (location == UNRESOLVED) location = glGetUniformLocation(program, names()[_index].c_str());
+	return location;
+}
+
+void UniformId::forget(GLuint program)
+{
+	std::vector<std::vector<GLint>>& programs = locations();
+	// a later program with the same handle queries its locations again
+	if (program < programs.size()) programs[program].clear();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <GL\glew.h>
+
+/*!
+ * Interned name of a uniform, created once (e.g. as a static constant) and then used instead of the name
+ * Every name gets a small index, locations are cached per shader program in a table indexed by it,
+ * so setting a uniform by id neither allocates nor hashes a string.
+ * OpenGL may reuse the handle of a deleted program, so every deletion has to call forget().
+ */
+class UniformId
+{
+protected:
+	/*!
+	 * Index of the name in the interned names
+	 */
+	unsigned int _index;
+
+	/*!
+	 * @return all interned names by index
+	 */
+	static std::vector<std::string>& names();
+	/*!
+	 * @return the cached locations by program handle and index
+	 */
+	static std::vector<std::vector<GLint>>& locations();
+
+public:
+	/*!
+	 * Interns a uniform name, ids of equal names share an index
+	 * @param name: the name of the uniform in the shader
+	 */
+	explicit UniformId(const char* name);
+
+	/*!
+	 * @return the index of the interned name
+	 */
+	unsigned int getIndex() const { return _index; }
+	/*!
+	 * @return the name of the uniform
+	 */
+	const std::string& getName() const;
+
+	/*!
+	 * Looks up the location of the uniform in a shader program, queried from OpenGL only on first use
+	 * @param program: the shader program handle
+	 * @return the location of the uniform (-1 if the program has no such uniform)
+	 */
+	GLint getLocation(GLuint program) const;
+
+	/*!
+	 * Drops the cached locations of a shader program, has to be called when the program is deleted
+	 * @param program: the shader program handle
+	 */
+	static void forget(GLuint program);
+
+	/*!
+	 * @return the number of interned names
+	 */
+	static size_t getCount() { return names().size(); }
+};
@@ -1,4 +1,70 @@
-#include "Utils.h";
+#include "Utils.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
 
+/* --------------------------------------------- */
+// Heap allocations
+/* --------------------------------------------- */
 
+static std::atomic<size_t> heapAllocations(0);
 
+// the array and nothrow forms forward to these
+void* operator new(size_t size)
+{
+	heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = malloc(size > 0 ? size : 1);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+size_t getHeapAllocationCount()
+{
+	return heapAllocations.load(std::memory_order_relaxed);
+}
+
+/* --------------------------------------------- */
+// Mapped file
+/* --------------------------------------------- */
+
+MappedFile::MappedFile(const char* path)
+	: _file(INVALID_HANDLE_VALUE), _mapping(NULL), _data(nullptr), _size(0)
+{
+	_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (_file == INVALID_HANDLE_VALUE) return;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(_file, &size)) {
+		CloseHandle(_file);
+		_file = INVALID_HANDLE_VALUE;
+		return;
+	}
+	_size = size_t(size.QuadPart);
+
+	// empty files cannot be mapped
+	if (_size == 0) return;
+
+	_mapping = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (_mapping != NULL) {
+		_data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (_data == nullptr) {
+		if (_mapping != NULL) CloseHandle(_mapping);
+		CloseHandle(_file);
+		_mapping = NULL;
+		_file = INVALID_HANDLE_VALUE;
+		_size = 0;
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (_data != nullptr) UnmapViewOfFile(_data);
+	if (_mapping != NULL) CloseHandle(_mapping);
+	if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+}
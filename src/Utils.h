@@ -19,41 +19,51 @@
 	system("PAUSE"); \
 	return EXIT_FAILURE;
 
-#define FOURCC_DXT1	MAKEFOURCC('D', 'X', 'T', '1')
-#define FOURCC_DXT3	MAKEFOURCC('D', 'X', 'T', '3')
-#define FOURCC_DXT5	MAKEFOURCC('D', 'X', 'T', '5')
-
 /*!
- * A loaded '.dss' image
+ * A read-only file that is mapped into memory as a whole
  */
-class DDSImage {
-public:
-	unsigned char* image;
-	unsigned int width;
-	unsigned int height;
-	unsigned int size;
-	GLenum format;
+class MappedFile {
+protected:
+	HANDLE _file;
+	HANDLE _mapping;
+	const char* _data;
+	size_t _size;
 
-	DDSImage() : image(nullptr), width(0), height(0), size(0), format(GL_NONE) {}
-	DDSImage(const DDSImage& img) = delete;
-	DDSImage(DDSImage&& img) : image(img.image), width(img.width), height(img.height), size(img.size), format(img.format) {
-		img.image = nullptr;
-	}
-	DDSImage& operator=(const DDSImage& img) = delete;
-	DDSImage& operator=(DDSImage&& img) {
-		image = img.image;
-		img.image = nullptr;
-		width = img.width;
-		height = img.height;
-		size = img.size;
-		format = img.format;
-		return *this;
-	};
+public:
+	/*!
+	 * Maps a file into memory
+	 * @param path: path to the file
+	 */
+	MappedFile(const char* path);
+	MappedFile(const MappedFile& file) = delete;
+	MappedFile& operator=(const MappedFile& file) = delete;
+	~MappedFile();
 
-	~DDSImage() { if (image != nullptr) { delete[] image; image = nullptr; } }
+	/*!
+	 * @return if the file could be opened and mapped
+	 */
+	bool isOpen() const { return _data != nullptr || (_file != INVALID_HANDLE_VALUE && _size == 0); }
+	/*!
+	 * @return pointer to the first byte of the file
+	 */
+	const char* data() const { return _data; }
+	/*!
+	 * @return size of the file in bytes
+	 */
+	size_t size() const { return _size; }
 };
 
 
+/* --------------------------------------------- */
+// Heap allocations
+/* --------------------------------------------- */
+
+/*!
+ * Global operator new is replaced to count heap allocations, e.g. to find allocations in the render loop
+ * @return the number of heap allocations since the program started
+ */
+size_t getHeapAllocationCount();
+
 /* --------------------------------------------- */
 // Framework functions
 /* --------------------------------------------- */
@@ -75,9 +85,3 @@ void drawTeapot();
  */
 void destroyFramework();
 
-/*!
- * Loads a '.dss' image from a file
- * @param file: the path to the image file
- * @return a loaded DSS image
- */
-DDSImage loadDDS(const char* file);